@@ -1,10 +1,10 @@
 TEMPLATE	= subdirs
 CONFIG		+= ordered
-SUBDIRS		= src tests
+SUBDIRS		= src tests tests/benchmarks runner
 
 # When compiling for Windows, don't compile tests
 win32 {
-SUBDIRS -= tests
+SUBDIRS -= tests tests/benchmarks
 }
 
 app.depends		= src
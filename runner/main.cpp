@@ -0,0 +1,289 @@
+/*
+ * PixelMaestro Runner - Plays Cuefiles without a GUI and reports how long each Maestro update takes.
+ *
+ * Usage: PixelMaestro_Runner [options] <cuefile or directory>...
+ *
+ * Maestro time comes from a virtual clock, so runs are as fast as the CPU allows and repeat exactly.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSettings>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <memory>
+#include "core/maestro.h"
+#include "core/section.h"
+#include "controller/idlescheduler.h"
+#include "controller/sectionupdater.h"
+#include "controller/timesource.h"
+#include "dialog/preferencesdialog.h"
+#include "utility/cuefileutility.h"
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+using namespace PixelMaestro;
+using namespace PixelMaestroStudio;
+
+/// Timing results for a single Cuefile.
+struct RunResult {
+	/// Cuefile location.
+	QString filename;
+
+	/// The number of Cues loaded from the Cuefile.
+	uint32_t num_cues = 0;
+
+	/// The total number of Pixels across every Section.
+	uint32_t num_pixels = 0;
+
+	/// The amount of Maestro time between frames in milliseconds. 0 if frames skipped ahead to the next change.
+	uint16_t timestep = 0;
+
+	/// The amount of Maestro time simulated in milliseconds.
+	uint64_t simulated_time = 0;
+
+	/// How long each update took in nanoseconds, sorted from fastest to slowest.
+	QVector<qint64> samples;
+};
+
+/**
+ * Expands the command line arguments into a list of Cuefiles.
+ * Directories are replaced with every Cuefile they contain.
+ * @param paths Files and directories passed on the command line.
+ * @return Cuefile locations.
+ */
+static QStringList find_cuefiles(const QStringList& paths) {
+	QStringList cuefiles;
+	for (const QString& path : paths) {
+		QFileInfo info(path);
+		if (info.isDir()) {
+			for (const QFileInfo& file : QDir(path).entryInfoList(QStringList("*.pmc"), QDir::Files, QDir::Name)) {
+				cuefiles.append(file.filePath());
+			}
+		}
+		else {
+			cuefiles.append(path);
+		}
+	}
+	return cuefiles;
+}
+
+/**
+ * Returns the peak amount of memory used by the process.
+ * @return Peak resident set size in kilobytes, or 0 if unavailable on this platform.
+ */
+static long get_peak_memory() {
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0) {
+	#ifdef Q_OS_MAC
+		return usage.ru_maxrss / 1024;	// macOS reports bytes
+	#else
+		return usage.ru_maxrss;
+	#endif
+	}
+#endif
+	return 0;
+}
+
+/**
+ * Returns a sample at the given percentile using the nearest-rank method.
+ * @param samples Sorted samples.
+ * @param percentile Percentile between 0 and 100.
+ * @return Sample in microseconds.
+ */
+static double get_percentile(const QVector<qint64>& samples, double percentile) {
+	if (samples.isEmpty()) return 0;
+
+	int rank = static_cast<int>((percentile / 100.0) * samples.size() + 0.5);
+	rank = qBound(1, rank, samples.size());
+	return samples[rank - 1] / 1000.0;
+}
+
+/**
+ * Loads a Cuefile into a new Maestro and times each update.
+ * The Maestro is set up the same way as in PixelMaestro Studio before the Cuefile is loaded.
+ * @param filename Cuefile to play.
+ * @param num_sections The number of Sections to create.
+ * @param dimensions The size of each Section.
+ * @param refresh The Maestro's default refresh interval.
+ * @param num_frames The number of frames to simulate. Ignored if duration is set.
+ * @param duration The amount of Maestro time to simulate in milliseconds. 0 simulates num_frames frames instead.
+ * @param timestep The amount of Maestro time between frames. 0 uses the Maestro's refresh interval.
+ * @param jump If true, each frame skips ahead to the next time the output can change instead of using the timestep.
+ * @param parallel If true, Sections are updated in parallel.
+ * @param result Where to store the results.
+ * @return True if the Cuefile was loaded.
+ */
+static bool run_cuefile(const QString& filename, uint8_t num_sections, const Point& dimensions, uint16_t refresh, uint32_t num_frames, uint64_t duration, uint16_t timestep, bool jump, bool parallel, RunResult& result) {
+	QFile file(filename);
+	if (!file.open(QFile::ReadOnly)) return false;
+	QByteArray bytes = file.readAll();
+
+	std::unique_ptr<Section[]> sections(new Section[num_sections]);
+	for (uint8_t section = 0; section < num_sections; section++) {
+		sections[section].set_dimensions(dimensions.x, dimensions.y);
+	}
+
+	Maestro maestro(nullptr, 0);
+	maestro.set_sections(sections.get(), num_sections);
+	maestro.set_timer(refresh);
+	CueController& controller = CuefileUtility::initialize_cue_controller(maestro);
+
+	result.filename = filename;
+	result.num_cues = CuefileUtility::read_cuefile(bytes, [&controller](uint8_t* cue) {
+		controller.run(cue);
+	});
+
+	result.num_pixels = 0;
+	for (uint8_t section = 0; section < maestro.get_num_sections(); section++) {
+		result.num_pixels += maestro.get_section(section)->get_dimensions().size();
+	}
+
+	if (jump) {
+		result.timestep = 0;
+	}
+	else {
+		result.timestep = (timestep > 0) ? timestep : maestro.get_timer().get_interval();
+	}
+
+	result.samples.clear();
+	if (duration == 0) {
+		result.samples.reserve(num_frames);
+	}
+	SectionUpdater updater;
+	updater.set_parallel(parallel);
+	QElapsedTimer timer;
+	VirtualTimeSource clock;
+	while ((duration > 0) ? clock.get_time() < duration : static_cast<uint32_t>(result.samples.size()) < num_frames) {
+		uint64_t time = jump ? IdleScheduler::get_next_update_time(maestro, clock.get_time()) : clock.get_time() + result.timestep;
+
+		// Stop once the output won't change again, or the next change is past the end of the run
+		if (time == IdleScheduler::NEVER || (duration > 0 && time > duration)) break;
+
+		// Updates where the Maestro's timer didn't fire don't produce a frame, so they aren't counted
+		clock.set_time(time);
+		timer.start();
+		if (updater.update(maestro, time, false)) {
+			result.samples.append(timer.nsecsElapsed());
+		}
+	}
+	result.simulated_time = (duration > 0) ? duration : clock.get_time();
+	std::sort(result.samples.begin(), result.samples.end());
+
+	return true;
+}
+
+int main(int argc, char* argv[]) {
+	// Use the same settings as PixelMaestro Studio
+	QCoreApplication::setOrganizationName("PixelMaestro");
+	QCoreApplication::setApplicationName("PixelMaestro Studio");
+
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationVersion(BUILD_VERSION);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Plays PixelMaestro Cuefiles without a GUI and reports how long each Maestro update takes.");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument("cuefiles", "Cuefiles to play, or directories containing Cuefiles.", "<cuefile or directory>...");
+
+	QCommandLineOption frames_option(QStringList() << "f" << "frames", "Number of frames to simulate (default: 1000).", "count", "1000");
+	QCommandLineOption duration_option(QStringList() << "d" << "duration", "Milliseconds of Maestro time to simulate. Overrides --frames.", "ms", "0");
+	QCommandLineOption timestep_option(QStringList() << "t" << "timestep", "Milliseconds of Maestro time between frames (default: the Maestro's refresh interval).", "ms", "0");
+	QCommandLineOption jump_option(QStringList() << "j" << "jump", "Skip ahead to the next time the output can change instead of stepping by --timestep.");
+	QCommandLineOption parallel_option(QStringList() << "p" << "parallel", "Update Sections in parallel (default: the setting in PixelMaestro Studio).");
+	QCommandLineOption serial_option("serial", "Update Sections one at a time.");
+	QCommandLineOption sections_option(QStringList() << "s" << "sections", "Number of Sections to create (default: the number set in PixelMaestro Studio).", "count");
+	QCommandLineOption size_option("size", "Size of each Section before the Cuefile is loaded (default: 10x10).", "WxH", "10x10");
+	parser.addOption(frames_option);
+	parser.addOption(duration_option);
+	parser.addOption(timestep_option);
+	parser.addOption(jump_option);
+	parser.addOption(parallel_option);
+	parser.addOption(serial_option);
+	parser.addOption(sections_option);
+	parser.addOption(size_option);
+	parser.process(app);
+
+	QTextStream out(stdout);
+	QTextStream err(stderr);
+
+	QStringList cuefiles = find_cuefiles(parser.positionalArguments());
+	if (cuefiles.isEmpty()) {
+		parser.showHelp(1);
+	}
+
+	// Match the defaults in PreferencesDialog
+	QSettings settings;
+	int num_sections = settings.value(PreferencesDialog::num_sections, 1).toInt();
+	uint16_t refresh = static_cast<uint16_t>(settings.value(PreferencesDialog::refresh_rate, 50).toUInt());
+	bool parallel = settings.value(PreferencesDialog::parallel_sections, false).toBool();
+	if (parser.isSet(parallel_option)) {
+		parallel = true;
+	}
+	if (parser.isSet(serial_option)) {
+		parallel = false;
+	}
+	if (parser.isSet(sections_option)) {
+		num_sections = parser.value(sections_option).toInt();
+	}
+
+	QStringList size = parser.value(size_option).split('x');
+	Point dimensions(10, 10);
+	if (size.size() == 2) {
+		dimensions = Point(size[0].toUShort(), size[1].toUShort());
+	}
+
+	uint32_t num_frames = parser.value(frames_option).toUInt();
+	uint64_t duration = parser.value(duration_option).toULongLong();
+	uint16_t timestep = parser.value(timestep_option).toUShort();
+	if (num_sections < 1 || num_sections > UINT8_MAX || (num_frames == 0 && duration == 0) || dimensions.size() == 0) {
+		err << "Invalid Section count, Section size, or frame count." << endl;
+		return 1;
+	}
+
+	out << "cuefile\tcues\tpixels\ttimestep_ms\tframes\tmean_us\tp50_us\tp90_us\tp99_us\tmax_us\tsimulated_ms" << endl;
+
+	int failures = 0;
+	RunResult result;
+	for (const QString& filename : cuefiles) {
+		if (!run_cuefile(filename, static_cast<uint8_t>(num_sections), dimensions, refresh, num_frames, duration, timestep, parser.isSet(jump_option), parallel, result)) {
+			err << "Unable to open " << filename << endl;
+			failures++;
+			continue;
+		}
+
+		qint64 total = 0;
+		for (qint64 sample : result.samples) {
+			total += sample;
+		}
+
+		out << QFileInfo(result.filename).fileName() << '\t'
+			<< result.num_cues << '\t'
+			<< result.num_pixels << '\t'
+			<< result.timestep << '\t'
+			<< result.samples.size() << '\t'
+			<< QString::number(result.samples.isEmpty() ? 0 : total / 1000.0 / result.samples.size(), 'f', 1) << '\t'
+			<< QString::number(get_percentile(result.samples, 50), 'f', 1) << '\t'
+			<< QString::number(get_percentile(result.samples, 90), 'f', 1) << '\t'
+			<< QString::number(get_percentile(result.samples, 99), 'f', 1) << '\t'
+			<< QString::number(result.samples.isEmpty() ? 0 : result.samples.last() / 1000.0, 'f', 1) << '\t'
+			<< result.simulated_time << endl;
+	}
+
+	long peak_memory = get_peak_memory();
+	if (peak_memory > 0) {
+		out << "Peak memory: " << peak_memory << " KB" << endl;
+	}
+
+	return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,381 @@
+#include <QDataStream>
+#include <QFutureInterface>
+#include <QMutexLocker>
+#include <QtConcurrent/QtConcurrentRun>
+#include <vector>
+#include "canvas/canvas.h"
+#include "core/maestro.h"
+#include "core/section.h"
+#include "cue/cuecontroller.h"
+#include "cue/sectioncuehandler.h"
+#include "cue/show.h"
+#include "cuefilecache.h"
+#include "utility/cuefileencoder.h"
+#include "utility/cuefileutility.h"
+#include "utility/performancemonitor.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * Every segment starts out invalid, so the first update encodes the whole Maestro.
+	 */
+	CuefileCache::CuefileCache() : encoder_maestro_(nullptr, 0) {
+		controller_ = &CuefileUtility::initialize_cue_controller(encoder_maestro_);
+	}
+
+	/**
+	 * Re-encodes every invalid segment, including Layers that scrolled or changed Canvas frames since they were encoded.
+	 * The cost depends on how much of the Maestro changed since the last update, not on the size of the whole Cuefile.
+	 * Must be called while holding mutex_.
+	 * @return Size of the Cuefile in bytes.
+	 */
+	uint32_t CuefileCache::encode() {
+		if (maestro_ == nullptr) return size_;
+
+		PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::CuefileGeneration);
+		QMutexLocker locker(maestro_mutex_);
+		Maestro& maestro = *maestro_;
+
+		// Show Events change the Maestro without going through a Cue we can see
+		Show* show = maestro.get_show();
+		uint16_t show_index = (show != nullptr) ? show->get_current_index() : 0;
+		if (show_index != show_index_) {
+			show_index_ = show_index;
+			invalidate_all();
+		}
+
+		if (!maestro_segment_.valid) {
+			size_ -= static_cast<uint32_t>(maestro_segment_.cues.size());
+			maestro_segment_.cues.clear();
+			QDataStream datastream(&maestro_segment_.cues, QIODevice::WriteOnly);
+			CuefileEncoder::save_maestro_settings(datastream, maestro, *controller_, default_interval_);
+			size_ += static_cast<uint32_t>(maestro_segment_.cues.size());
+			maestro_segment_.valid = true;
+		}
+
+		// Layers that no longer exist drop out of the total, and new ones get encoded below
+		uint8_t num_sections = maestro.get_num_sections();
+		for (int section = num_sections; section < section_segments_.size(); section++) {
+			resize(section_segments_[section], 0);
+		}
+		section_segments_.resize(num_sections);
+
+		std::vector<uint8_t> changed_sections;
+		for (uint8_t section = 0; section < num_sections; section++) {
+			int num_layers = 1;
+			for (Section::Layer* layer = maestro.get_section(section)->get_layer(); layer != nullptr; layer = layer->section->get_layer()) {
+				num_layers++;
+			}
+			resize(section_segments_[section], num_layers);
+
+			// Take invalid segments out of the total. They're added back once they're encoded.
+			bool changed = false;
+			Section* layer_section = maestro.get_section(section);
+			for (Segment& segment : section_segments_[section]) {
+				if (segment.valid && is_moved(segment, *layer_section)) {
+					segment.valid = false;
+				}
+				if (layer_section->get_layer() != nullptr) {
+					layer_section = layer_section->get_layer()->section;
+				}
+
+				if (segment.valid) continue;
+				size_ -= static_cast<uint32_t>(segment.cues.size());
+				changed = true;
+			}
+			if (changed) {
+				changed_sections.push_back(section);
+			}
+		}
+
+		CuefileEncoder::encode_sections(*controller_, changed_sections, [this](CueController& controller, uint8_t section) {
+			encode_section(controller, section);
+		});
+
+		for (uint8_t section : changed_sections) {
+			for (Segment& segment : section_segments_[section]) {
+				if (segment.valid) continue;
+				size_ += static_cast<uint32_t>(segment.cues.size());
+				segment.valid = true;
+			}
+		}
+
+		return size_;
+	}
+
+	/**
+	 * Encodes a Section's invalid segments.
+	 * Segments are left marked invalid so that update() can add them back into the total.
+	 * @param controller CueController used to build the Cues.
+	 * @param section Section index.
+	 */
+	void CuefileCache::encode_section(CueController& controller, uint8_t section) {
+		QVector<Segment>& layers = section_segments_[section];
+		Section* layer_section = maestro_->get_section(section);
+		for (int layer = 0; layer < layers.size(); layer++) {
+			Segment& segment = layers[layer];
+			if (!segment.valid) {
+				segment.cues.clear();
+				QDataStream datastream(&segment.cues, QIODevice::WriteOnly);
+				CuefileEncoder::save_layer(datastream, *maestro_, controller, section, static_cast<uint8_t>(layer));
+
+				segment.offset = layer_section->get_offset();
+				Canvas* canvas = layer_section->get_canvas();
+				segment.frame_index = (canvas != nullptr) ? canvas->get_current_frame_index() : 0;
+			}
+
+			if (layer_section->get_layer() != nullptr) {
+				layer_section = layer_section->get_layer()->section;
+			}
+		}
+	}
+
+	/**
+	 * Builds the Cuefile on a worker thread.
+	 * If the Maestro has a mutex, changed segments are also encoded on the worker while holding it. Otherwise, they're encoded on the calling thread before this returns, since the Maestro can only be read safely there.
+	 * Progress is reported as the number of segments joined so far, and doesn't include encoding.
+	 * @return Future holding the Cuefile.
+	 */
+	QFuture<QByteArray> CuefileCache::generate() {
+		bool encoded = (maestro_mutex_ == nullptr);
+		uint32_t size = 0;
+		QVector<QByteArray> snapshot;
+		if (encoded) {
+			QMutexLocker locker(&mutex_);
+			size = encode();
+			snapshot = get_snapshot();
+		}
+
+		QFutureInterface<QByteArray> promise;
+		promise.reportStarted();
+		QtConcurrent::run(&workers_, [this, promise, snapshot, size, encoded]() mutable {
+			if (!encoded) {
+				QMutexLocker locker(&mutex_);
+				size = encode();
+				snapshot = get_snapshot();
+			}
+
+			promise.setProgressRange(0, snapshot.size());
+			QByteArray cuefile;
+			cuefile.reserve(static_cast<int>(size));
+			for (int segment = 0; segment < snapshot.size(); segment++) {
+				cuefile.append(snapshot[segment]);
+				promise.setProgressValue(segment + 1);
+			}
+			promise.reportResult(cuefile);
+			promise.reportFinished();
+		});
+
+		return promise.future();
+	}
+
+	/**
+	 * Brings the Cuefile up to date and returns it.
+	 * @return Maestro Cuefile.
+	 */
+	QByteArray CuefileCache::get_cuefile() {
+		QMutexLocker locker(&mutex_);
+		uint32_t size = encode();
+		return join(get_snapshot(), size);
+	}
+
+	/**
+	 * Returns the refresh interval that the Maestro's timer is compared against when saving.
+	 * @return Default refresh interval in milliseconds.
+	 */
+	uint16_t CuefileCache::get_default_interval() const {
+		QMutexLocker locker(&mutex_);
+		return default_interval_;
+	}
+
+	/**
+	 * Returns every segment in Cuefile order.
+	 * The segments share their data with the cache, so this doesn't copy any Cues. Must be called while holding mutex_.
+	 * @return Segment contents.
+	 */
+	QVector<QByteArray> CuefileCache::get_snapshot() {
+		QVector<QByteArray> snapshot;
+		snapshot.append(maestro_segment_.cues);
+		for (const QVector<Segment>& section : section_segments_) {
+			for (const Segment& layer : section) {
+				snapshot.append(layer.cues);
+			}
+		}
+		return snapshot;
+	}
+
+	/**
+	 * Marks the entire Cuefile for re-encoding.
+	 * Use this when the Maestro changes in a way that can't be traced to a single Cue, such as changing the number of Sections.
+	 */
+	void CuefileCache::invalidate() {
+		QMutexLocker locker(&mutex_);
+		invalidate_all();
+	}
+
+	/**
+	 * Marks every segment for re-encoding. Must be called while holding mutex_.
+	 */
+	void CuefileCache::invalidate_all() {
+		maestro_segment_.valid = false;
+		for (QVector<Segment>& section : section_segments_) {
+			for (Segment& layer : section) {
+				layer.valid = false;
+			}
+		}
+	}
+
+	/**
+	 * Marks the parts of the Cuefile affected by a Cue for re-encoding.
+	 * @param cue Cue that was run on the Maestro.
+	 */
+	void CuefileCache::invalidate(const uint8_t* cue) {
+		QMutexLocker locker(&mutex_);
+		CueController::Handler handler = static_cast<CueController::Handler>(cue[static_cast<uint8_t>(CueController::Byte::PayloadByte)]);
+		switch (handler) {
+			case CueController::Handler::MaestroCueHandler:
+				// Maestro Cues can replace the Show or every Section
+				invalidate_all();
+				break;
+			case CueController::Handler::ShowCueHandler:
+				maestro_segment_.valid = false;
+				break;
+			default:
+				{
+					// SectionByte and LayerByte are the same for all Section-related handlers
+					uint8_t section = cue[static_cast<uint8_t>(SectionCueHandler::Byte::SectionByte)];
+					uint8_t layer = cue[static_cast<uint8_t>(SectionCueHandler::Byte::LayerByte)];
+
+					// Section Cues can resize or add and remove the Layers above
+					invalidate(section, layer, handler == CueController::Handler::SectionCueHandler);
+				}
+				break;
+		}
+	}
+
+	/**
+	 * Marks a Layer's segment for re-encoding. Must be called while holding mutex_.
+	 * @param section Section index.
+	 * @param layer Layer index.
+	 * @param above If true, also marks every Layer above this one.
+	 */
+	void CuefileCache::invalidate(uint8_t section, uint8_t layer, bool above) {
+		if (section >= section_segments_.size()) return;
+
+		QVector<Segment>& layers = section_segments_[section];
+		int last = above ? layers.size() : qMin(layer + 1, layers.size());
+		for (int index = layer; index < last; index++) {
+			layers[index].valid = false;
+		}
+	}
+
+	/**
+	 * Checks whether a Layer scrolled or changed frames since its segment was encoded.
+	 * Neither goes through a Cue, but both are saved in the Cuefile.
+	 * @param segment Layer's segment.
+	 * @param section The Layer's Section.
+	 * @return True if the segment needs to be re-encoded.
+	 */
+	bool CuefileCache::is_moved(const Segment& segment, Section& section) {
+		Point& offset = section.get_offset();
+		if (offset.x != segment.offset.x || offset.y != segment.offset.y) {
+			return true;
+		}
+
+		Canvas* canvas = section.get_canvas();
+		return (canvas != nullptr && canvas->get_current_frame_index() != segment.frame_index);
+	}
+
+	/**
+	 * Joins segments into a single Cuefile.
+	 * @param snapshot Segments to join.
+	 * @param size Combined size of the segments.
+	 * @return Cuefile.
+	 */
+	QByteArray CuefileCache::join(const QVector<QByteArray>& snapshot, uint32_t size) {
+		QByteArray cuefile;
+		cuefile.reserve(static_cast<int>(size));
+		for (const QByteArray& segment : snapshot) {
+			cuefile.append(segment);
+		}
+		return cuefile;
+	}
+
+	/**
+	 * Resizes a list of segments while keeping the total size accurate.
+	 * New segments start out invalid.
+	 * @param segments Segments to resize.
+	 * @param size New number of segments.
+	 */
+	void CuefileCache::resize(QVector<Segment>& segments, int size) {
+		for (int index = size; index < segments.size(); index++) {
+			size_ -= static_cast<uint32_t>(segments[index].cues.size());
+		}
+		segments.resize(size);
+	}
+
+	/**
+	 * Sets the refresh interval that the Maestro's timer is compared against when saving.
+	 * @param interval Default refresh interval in milliseconds.
+	 */
+	void CuefileCache::set_default_interval(uint16_t interval) {
+		QMutexLocker locker(&mutex_);
+		if (interval != default_interval_) {
+			default_interval_ = interval;
+			maestro_segment_.valid = false;
+		}
+	}
+
+	/**
+	 * Sets the Maestro to encode and marks the entire Cuefile for re-encoding.
+	 * @param maestro Maestro to encode.
+	 * @param mutex Locks the Maestro while it's being read. If null, the Maestro must only be touched from the thread calling update().
+	 */
+	void CuefileCache::set_maestro(Maestro& maestro, QMutex* mutex) {
+		wait();
+		QMutexLocker locker(&mutex_);
+		maestro_ = &maestro;
+		maestro_mutex_ = mutex;
+		show_index_ = 0;
+		invalidate_all();
+	}
+
+	/**
+	 * Re-encodes every invalid segment on the calling thread.
+	 * @return Size of the Cuefile in bytes.
+	 */
+	uint32_t CuefileCache::update() {
+		QMutexLocker locker(&mutex_);
+		return encode();
+	}
+
+	/**
+	 * Re-encodes every invalid segment on a worker thread if the Maestro can be locked, or on the calling thread if not.
+	 * @return Future holding the size of the Cuefile in bytes.
+	 */
+	QFuture<uint32_t> CuefileCache::update_in_background() {
+		if (maestro_mutex_ != nullptr) {
+			return QtConcurrent::run(&workers_, [this]() {
+				return update();
+			});
+		}
+
+		QFutureInterface<uint32_t> promise;
+		promise.reportStarted();
+		promise.reportResult(update());
+		promise.reportFinished();
+		return promise.future();
+	}
+
+	/**
+	 * Waits for every background update to finish.
+	 * Call this before deleting or replacing the Maestro.
+	 */
+	void CuefileCache::wait() {
+		workers_.waitForDone();
+	}
+
+	CuefileCache::~CuefileCache() {
+		wait();
+	}
+}
@@ -0,0 +1,102 @@
+/*
+ * CuefileCache - Keeps the Maestro's Cuefile as separately encoded pieces, so that running a Cue only re-encodes the part of the Maestro that it changed.
+ * The Cuefile is split into one segment for Maestro and Show settings, plus one segment for each Layer of each Section (Layer 0 being the Section itself). After update(), joining the segments in order gives the same bytes as MaestroController::save_maestro_to_datastream().
+ * Scrolling and Canvas frame timers change a Layer's offset and current frame without running a Cue, so update() also re-encodes Layers whose offset or frame moved since they were encoded.
+ * Sections with changed segments are encoded in parallel through CuefileEncoder::encode_sections(), the same path used for a full save.
+ * When the Maestro has a mutex (i.e. it runs on the simulation thread), generate() and update_in_background() encode changed segments on a worker thread while holding it. Otherwise, the Maestro can only be read on the thread that owns it, so they encode on the calling thread and only the join runs on the worker.
+ * Segments are implicitly shared, so taking a snapshot of them is cheap. The cache's own state is guarded by its own mutex, which is always taken before the Maestro's.
+ */
+
+#ifndef CUEFILECACHE_H
+#define CUEFILECACHE_H
+
+#include <QByteArray>
+#include <QFuture>
+#include <QMutex>
+#include <QThreadPool>
+#include <QVector>
+#include <stdint.h>
+#include "core/maestro.h"
+#include "core/point.h"
+#include "core/section.h"
+#include "cue/cuecontroller.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class CuefileCache {
+		public:
+			CuefileCache();
+			~CuefileCache();
+			QFuture<QByteArray> generate();
+			QByteArray get_cuefile();
+			uint16_t get_default_interval() const;
+			void invalidate();
+			void invalidate(const uint8_t* cue);
+			void set_default_interval(uint16_t interval);
+			void set_maestro(Maestro& maestro, QMutex* mutex);
+			uint32_t update();
+			QFuture<uint32_t> update_in_background();
+			void wait();
+
+		private:
+			/// Encoded Cues for one part of the Maestro.
+			struct Segment {
+				/// The part's Cues.
+				QByteArray cues;
+
+				/// Whether cues matches the Maestro's current state.
+				bool valid = false;
+
+				/// The Layer's offset when it was encoded.
+				Point offset = Point(0, 0);
+
+				/// The Layer's current Canvas frame when it was encoded.
+				uint16_t frame_index = 0;
+			};
+
+			/// Builds Cues, so that encoding doesn't touch the buffer of the Maestro's CueController while the UI builds Cues in it.
+			CueController* controller_ = nullptr;
+
+			/// The Maestro's refresh interval on startup. The Maestro's timer is only saved if it differs.
+			uint16_t default_interval_ = 50;
+
+			/// Owns controller_.
+			Maestro encoder_maestro_;
+
+			/// The Maestro to encode.
+			Maestro* maestro_ = nullptr;
+
+			/// Locks the Maestro while it's being read. If null, the Maestro is only touched from the calling thread.
+			QMutex* maestro_mutex_ = nullptr;
+
+			/// Maestro and Show settings.
+			Segment maestro_segment_;
+
+			/// Guards the cache's state, since updates can run on a worker thread. Always taken before maestro_mutex_.
+			mutable QMutex mutex_;
+
+			/// Segments for each Layer of each Section, indexed by Section, then by Layer.
+			QVector<QVector<Segment>> section_segments_;
+
+			/// The Show's current Event index as of the last update.
+			uint16_t show_index_ = 0;
+
+			/// Combined size of every segment.
+			uint32_t size_ = 0;
+
+			/// Runs background updates, so that they can be waited on before the Maestro is deleted.
+			QThreadPool workers_;
+
+			uint32_t encode();
+			void encode_section(CueController& controller, uint8_t section);
+			QVector<QByteArray> get_snapshot();
+			void invalidate_all();
+			void invalidate(uint8_t section, uint8_t layer, bool above);
+			static bool is_moved(const Segment& segment, Section& section);
+			static QByteArray join(const QVector<QByteArray>& snapshot, uint32_t size);
+			void resize(QVector<Segment>& segments, int size);
+	};
+}
+
+#endif // CUEFILECACHE_H
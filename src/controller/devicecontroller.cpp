@@ -2,37 +2,24 @@
  * SerialDevice - Utility class for managing devices connected via USB/Bluetooth.
  */
 
-#include <QRegularExpression>
-#include <QSerialPort>
 #include <QSettings>
-#include <QTcpSocket>
 #include "dialog/preferencesdialog.h"
 #include "devicecontroller.h"
+#include "devicethreadcontroller.h"
 #include "widget/maestrocontrolwidget.h"
 
 namespace PixelMaestroStudio {
 	/**
 	 * Constructor.
-	 * @param port_name The full path name to the device.
 	 */
-	DeviceController::DeviceController(const QString& port_name) {
-		this->port_name_ = port_name;
+	DeviceController::DeviceController() : thread_(new DeviceThreadController(statistics_)) { }
 
-		/*
-		 * Check whether the port name is an IP address.
-		 * If so, initialize a TCP socket.
-		 * Otherwise, assume a serial device.
-		 */
-		QRegularExpression exp("^(?:[0-9]{1,3}.){3}[0-9]{1,3}");
-		bool is_network_device = exp.match(port_name).hasMatch();
-		if (is_network_device) {
-			this->device_ = QSharedPointer<QTcpSocket>(new QTcpSocket());
-			this->device_type_ = DeviceType::TCP;
-		}
-		else {
-			this->device_ = QSharedPointer<QSerialPort>(new QSerialPort());
-			this->device_type_ = DeviceType::Serial;
-		}
+	/**
+	 * Constructor.
+	 * @param port_name The full path name to the device.
+	 */
+	DeviceController::DeviceController(const QString& port_name) : DeviceController() {
+		set_port_name(port_name);
 
 		// Look up the device in settings
 		QSettings settings;
@@ -65,73 +52,27 @@ namespace PixelMaestroStudio {
 	}
 
 	/**
-	 * Connects to the device.
-	 * @return True if a connection was established.
+	 * Cancels a write sent to the device.
+	 * @param write_id Write returned by write().
 	 */
-	bool DeviceController::connect() {
-		if (device_type_ == DeviceType::Serial) {
-			QSerialPort* serial_device = dynamic_cast<QSerialPort*>(device_.data());
-
-			if (!serial_device) return false;
-
-			serial_device->setPortName(port_name_);
-			serial_device->setBaudRate(baud_rate_);
-
-			// Set comm settings
-			serial_device->setFlowControl(QSerialPort::FlowControl::NoFlowControl);
-			serial_device->setParity(QSerialPort::Parity::NoParity);
-			serial_device->setDataBits(QSerialPort::DataBits::Data8);
-			serial_device->setStopBits(QSerialPort::StopBits::OneStop);
-
-			return (serial_device->open(QIODevice::WriteOnly));
-		}
-		else if (device_type_ == DeviceType::TCP) {
-			// Extract the IP address and port number
-			QRegularExpression address_re("^(?:[0-9]{1,3}\\.){3}[0-9]{1,3}");
-			QRegularExpression port_re("[^:][0-9]+$");
-
-			QString address = address_re.match(port_name_).captured(0);
-			QString port = port_re.match(port_name_).captured(0);
-
-			// If no port number is found, use the default
-			uint16_t port_num = static_cast<uint16_t>(port.toUInt());
-			if (port_num == 0) {
-				QSettings settings;
-				port_num = PORT_NUM;
-			}
-
-			QTcpSocket* tcp_device = dynamic_cast<QTcpSocket*>(device_.data());
-
-			if (!tcp_device) return false;
-
-			tcp_device->connectToHost(address, port_num);
-
-			// Wait for a connection
-			// TODO: Make non-blocking
-			return tcp_device->waitForConnected(TIMEOUT);
-		}
-
-		return false;
+	void DeviceController::cancel(uint32_t write_id) {
+		thread_->cancel(write_id);
 	}
 
 	/**
-	 * Disconnects the device.
-	 * @return True if the disconnection was successful.
+	 * Connects to the device.
+	 * Returns immediately. The device's thread reports the result through its connected() and error() signals.
 	 */
-	bool DeviceController::disconnect() {
-		if (device_type_ == DeviceType::Serial && device_) {
-			bool flushed = dynamic_cast<QSerialPort*>(device_.data())->flush();
-			device_->close();
-			return flushed;
-		}
-		else if (device_type_ == DeviceType::TCP && device_) {
-			QTcpSocket* tcp_device = dynamic_cast<QTcpSocket*>(device_.data());
-			tcp_device->flush();
-			tcp_device->disconnectFromHost();
-			return true;
-		}
+	void DeviceController::connect() {
+		thread_->open_device(port_name_, baud_rate_);
+	}
 
-		return false;
+	/**
+	 * Disconnects the device once every pending write is done.
+	 * Returns immediately. The device's thread emits disconnected() once the device is closed.
+	 */
+	void DeviceController::disconnect() {
+		thread_->close_device();
 	}
 
 	/**
@@ -143,11 +84,11 @@ namespace PixelMaestroStudio {
 	}
 
 	/**
-	 * Returns the actual device object.
-	 * @return Device.
+	 * Returns a description of the last error the device ran into.
+	 * @return Error message.
 	 */
-	QIODevice* DeviceController::get_device() const {
-		return device_.data();
+	QString DeviceController::get_error() const {
+		return thread_->get_error();
 	}
 
 	/**
@@ -155,16 +96,7 @@ namespace PixelMaestroStudio {
 	 * @return True if the device is connected.
 	 */
 	bool DeviceController::get_open() const {
-		if (device_) {
-			switch (device_type_) {
-				case DeviceType::Serial:
-					return dynamic_cast<QSerialPort*>(device_.data())->isOpen();
-				case DeviceType::TCP:
-					return dynamic_cast<QTcpSocket*>(device_.data())->state() == QAbstractSocket::ConnectedState;
-			}
-		}
-
-		return false;
+		return thread_->get_open();
 	}
 
 	/**
@@ -175,6 +107,14 @@ namespace PixelMaestroStudio {
 		return port_name_;
 	}
 
+	/**
+	 * Returns the device's traffic counters.
+	 * @return Traffic counters.
+	 */
+	DeviceController::Statistics& DeviceController::get_statistics() const {
+		return *statistics_;
+	}
+
 	/**
 	 * Returns whether real-time refreshing is enabled for this device.
 	 * @return True if enabled.
@@ -184,17 +124,12 @@ namespace PixelMaestroStudio {
 	}
 
 	/**
-	 * Writes any buffered data to the device.
+	 * Returns the thread that performs the device's I/O.
+	 * Connect to its signals to follow the connection and the progress of writes.
+	 * @return Device thread.
 	 */
-	void DeviceController::flush() {
-		switch (device_type_) {
-			case DeviceType::Serial:
-				dynamic_cast<QSerialPort*>(device_.data())->flush();
-				break;
-			case DeviceType::TCP:
-				dynamic_cast<QTcpSocket*>(device_.data())->flush();
-				break;
-		}
+	DeviceThreadController* DeviceController::get_thread() const {
+		return thread_.data();
 	}
 
 	/**
@@ -211,6 +146,7 @@ namespace PixelMaestroStudio {
 	 */
 	void DeviceController::set_port_name(const QString &port_name) {
 		this->port_name_ = port_name;
+		thread_->setObjectName(port_name);
 	}
 
 	/**
@@ -221,4 +157,14 @@ namespace PixelMaestroStudio {
 	void DeviceController::set_real_time_update(bool enabled) {
 		this->real_time_updates_ = enabled;
 	}
+
+	/**
+	 * Queues data to write to the device.
+	 * Returns immediately. The write runs on the device's thread, which reports its progress.
+	 * @param array Data to write.
+	 * @return ID of the write.
+	 */
+	uint32_t DeviceController::write(const QByteArray &array) {
+		return thread_->write(array);
+	}
 }
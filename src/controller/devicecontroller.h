@@ -5,12 +5,15 @@
 #ifndef SERIALDEVICE_H
 #define SERIALDEVICE_H
 
-#include <QIODevice>
+#include <QByteArray>
 #include <QSharedPointer>
 #include <QString>
+#include <atomic>
 #include "model/sectionmapmodel.h"
 
 namespace PixelMaestroStudio {
+	class DeviceThreadController;
+
 	class DeviceController {
 		public:
 			enum DeviceType {
@@ -18,27 +21,37 @@ namespace PixelMaestroStudio {
 				TCP
 			};
 
+			/// Traffic counters. Updated from the write path without locking, so they can be read at any time.
+			struct Statistics {
+				/// Total bytes written to the device.
+				std::atomic<uint64_t> bytes_written{0};
+
+				/// Writes that have been started but haven't finished.
+				std::atomic<uint32_t> pending_writes{0};
+			};
+
 			/// Default connect/disconnect timeout to 10 seconds
 			static const uint16_t TIMEOUT = 10000;
 			static const uint16_t PORT_NUM = 8077;
 
-			DeviceController() = default;
+			DeviceController();
 			explicit DeviceController(const QString& port_name);
-			bool connect();
-			bool disconnect();
+			void cancel(uint32_t write_id);
+			void connect();
+			void disconnect();
 			int get_capacity() const;
-			QIODevice* get_device() const;
 			QString get_error() const;
 			bool get_open() const;
 			QString get_port_name() const;
+			Statistics& get_statistics() const;
 			bool get_autoconnect() const;
 			bool get_real_time_refresh_enabled() const;
-			void flush();
+			DeviceThreadController* get_thread() const;
 			void set_autoconnect(const bool autoconnect);
 			void set_capacity(const int capacity);
 			void set_port_name(const QString &port_name);
 			void set_real_time_update(const bool enabled);
-			void write(const QByteArray &array);
+			uint32_t write(const QByteArray &array);
 
 			/// Custom mapping of local Sections to remote Sections. Made public because of weird pointer issues. Fix later.
 			SectionMapModel* section_map_model = nullptr;
@@ -53,17 +66,17 @@ namespace PixelMaestroStudio {
 			/// The maximum number of bytes the device's ROM can hold.
 			int capacity_ = 1024;
 
-			/// The actual device type.
-			QSharedPointer<QIODevice> device_;
-
-			/// The type of connected device.
-			DeviceType device_type_	= DeviceType::Serial;
-
 			/// The full path to the device (QSerialPortInfo::systemLocation()).
 			QString port_name_;
 
 			/// If true, commands will be sent to the device in real-time.
 			bool real_time_updates_ = false;
+
+			/// Traffic counters. Shared between copies of the DeviceController so that counts aren't lost when the device list is copied.
+			QSharedPointer<Statistics> statistics_ = QSharedPointer<Statistics>(new Statistics());
+
+			/// Thread that owns the device and performs all I/O. Shared between copies of the DeviceController, and stopped once the last copy is gone.
+			QSharedPointer<DeviceThreadController> thread_;
 	};
 }
 
@@ -1,43 +1,337 @@
-#include <QByteArray>
+#include <QMutexLocker>
+#include <QRegularExpression>
+#include <QSerialPort>
+#include <QTcpSocket>
 #include "devicethreadcontroller.h"
+#include "utility/performancemonitor.h"
+#include "utility/tracerecorder.h"
 
 namespace PixelMaestroStudio {
-	DeviceThreadController::DeviceThreadController(DeviceController& device, const char *out, int size) : QThread(nullptr), device_(device) {
-		this->output_.append(out, size);
+	/**
+	 * Constructor.
+	 * The thread starts the first time it's sent a request.
+	 * @param statistics Traffic counters to update.
+	 */
+	DeviceThreadController::DeviceThreadController(QSharedPointer<DeviceController::Statistics> statistics) : QThread(nullptr), statistics_(statistics) { }
+
+	/**
+	 * Cancels a single write.
+	 * If the write is still queued, it's dropped. If it's in progress, it stops after its current chunk. Other writes are unaffected.
+	 * @param write_id Write returned by write().
+	 */
+	void DeviceThreadController::cancel(uint32_t write_id) {
+		QMutexLocker locker(&mutex_);
+		if (write_id > finished_id_) {
+			cancelled_ids_.insert(write_id);
+		}
+	}
+
+	/**
+	 * Closes the device (runs on the thread).
+	 */
+	void DeviceThreadController::close() {
+		open_ = false;
+		if (device_.isNull()) return;
+
+		QTcpSocket* tcp_device = qobject_cast<QTcpSocket*>(device_.data());
+		if (tcp_device) {
+			tcp_device->flush();
+			tcp_device->disconnectFromHost();
+			if (tcp_device->state() != QAbstractSocket::UnconnectedState) {
+				tcp_device->waitForDisconnected(DeviceController::TIMEOUT);
+			}
+		}
+		else {
+			device_->close();
+		}
+		device_.reset();
+	}
+
+	/**
+	 * Closes the device once every write sent before this call is done.
+	 * Returns immediately. disconnected() is emitted once the device is closed.
+	 */
+	void DeviceThreadController::close_device() {
+		send(Request::Type::Close);
+	}
+
+	/**
+	 * Returns whether a write was cancelled.
+	 * @param write_id Write to check.
+	 * @return True if cancelled.
+	 */
+	bool DeviceThreadController::get_cancelled(uint32_t write_id) const {
+		QMutexLocker locker(&mutex_);
+		return cancelled_ids_.contains(write_id);
+	}
+
+	/**
+	 * Returns whether the device is still connected (runs on the thread).
+	 * @return True if connected.
+	 */
+	bool DeviceThreadController::get_connected() const {
+		if (device_.isNull() || !device_->isOpen()) return false;
+
+		QTcpSocket* tcp_device = qobject_cast<QTcpSocket*>(device_.data());
+		return (tcp_device == nullptr || tcp_device->state() == QAbstractSocket::ConnectedState);
+	}
+
+	/**
+	 * Returns a description of the last error.
+	 * @return Error message.
+	 */
+	QString DeviceThreadController::get_error() const {
+		QMutexLocker locker(&mutex_);
+		return error_;
+	}
+
+	/**
+	 * Returns whether the device is connected and writeable.
+	 * @return True if the device is connected.
+	 */
+	bool DeviceThreadController::get_open() const {
+		return open_;
+	}
+
+	/**
+	 * Opens the device (runs on the thread).
+	 * @param port_name Serial port or IP address of the device.
+	 * @param baud_rate Baud rate for serial devices.
+	 * @return True if a connection was established.
+	 */
+	bool DeviceThreadController::open(const QString& port_name, int baud_rate) {
+		close();
+
+		/*
+		 * Check whether the port name is an IP address.
+		 * If so, initialize a TCP socket.
+		 * Otherwise, assume a serial device.
+		 */
+		QRegularExpression exp("^(?:[0-9]{1,3}.){3}[0-9]{1,3}");
+		bool connected = false;
+		if (exp.match(port_name).hasMatch()) {
+			// Extract the IP address and port number
+			QRegularExpression address_re("^(?:[0-9]{1,3}\\.){3}[0-9]{1,3}");
+			QRegularExpression port_re("[^:][0-9]+$");
+
+			QString address = address_re.match(port_name).captured(0);
+			QString port = port_re.match(port_name).captured(0);
+
+			// If no port number is found, use the default
+			uint16_t port_num = static_cast<uint16_t>(port.toUInt());
+			if (port_num == 0) {
+				port_num = DeviceController::PORT_NUM;
+			}
+
+			QTcpSocket* tcp_device = new QTcpSocket();
+			device_.reset(tcp_device);
+			tcp_device->connectToHost(address, port_num);
+			connected = tcp_device->waitForConnected(DeviceController::TIMEOUT);
+		}
+		else {
+			QSerialPort* serial_device = new QSerialPort();
+			device_.reset(serial_device);
+			serial_device->setPortName(port_name);
+			serial_device->setBaudRate(baud_rate);
+
+			// Set comm settings
+			serial_device->setFlowControl(QSerialPort::FlowControl::NoFlowControl);
+			serial_device->setParity(QSerialPort::Parity::NoParity);
+			serial_device->setDataBits(QSerialPort::DataBits::Data8);
+			serial_device->setStopBits(QSerialPort::StopBits::OneStop);
+
+			connected = serial_device->open(QIODevice::WriteOnly);
+		}
+
+		if (!connected) {
+			set_error(device_->errorString());
+			device_.reset();
+		}
+		open_ = connected;
+		return connected;
+	}
+
+	/**
+	 * Opens the device.
+	 * Returns immediately. connected() is emitted if the device opens, and error() if it doesn't.
+	 * @param port_name Serial port or IP address of the device.
+	 * @param baud_rate Baud rate for serial devices.
+	 */
+	void DeviceThreadController::open_device(const QString& port_name, int baud_rate) {
+		send(Request::Type::Open, port_name.toUtf8(), baud_rate);
 	}
 
 	void DeviceThreadController::run() {
 		/*
 		 * How this works:
 		 *
+		 * The thread sleeps until a request arrives, then runs requests in the order they were sent. Since every write goes through the same queue, Cues reach the device in the same order they were run.
+		 * Results are only reported through signals, so nothing ever waits on the thread.
+		 *
 		 * When sending data to an Arduino, the Arduino might fail to process large chunks even at a low baud rate.
 		 * This tends to happen at the 64 byte mark.
-		 * As a workaround, we break up the output into 64 byte chunks and give the Arduino some time between chunks to catch up.
-		 *
+		 * As a workaround, we break up the output into 64 byte chunks and wait for each chunk to leave before sending the next.
 		 */
+		TraceRecorder::set_thread_name(QString("Device %1").arg(objectName()));
 
-		emit progress_changed(0);
+		QMutexLocker locker(&mutex_);
+		while (!isInterruptionRequested()) {
+			if (requests_.isEmpty()) {
+				wake_condition_.wait(&mutex_);
+				continue;
+			}
 
+			Request request = requests_.dequeue();
+			locker.unlock();
+
+			switch (request.type) {
+				case Request::Type::Open:
+					if (open(QString::fromUtf8(request.data), request.baud_rate)) {
+						emit connected();
+					}
+					else {
+						emit error(QString("Unable to connect: ") + get_error());
+					}
+					break;
+				case Request::Type::Close:
+					{
+						bool flushed = (device_.isNull() || device_->bytesToWrite() == 0 || device_->waitForBytesWritten(DeviceController::TIMEOUT));
+						close();
+						if (!flushed) {
+							set_error("Unable to send the remaining data before disconnecting.");
+							emit error(get_error());
+						}
+						emit disconnected();
+					}
+					break;
+				case Request::Type::Write:
+					write_data(request);
+					break;
+			}
+
+			locker.relock();
+			finished_id_ = request.id;
+			cancelled_ids_.remove(request.id);
+		}
+
+		// Drop anything still in the queue
+		while (!requests_.isEmpty()) {
+			Request request = requests_.dequeue();
+			if (request.type == Request::Type::Write) {
+				statistics_->pending_writes.fetch_sub(1, std::memory_order_relaxed);
+			}
+		}
+		cancelled_ids_.clear();
+		locker.unlock();
+
+		close();
+	}
+
+	/**
+	 * Queues a request and wakes the thread.
+	 * @param type Request type.
+	 * @param data Bytes to write, or the port to open.
+	 * @param baud_rate Baud rate for Open requests.
+	 * @return ID of the request.
+	 */
+	uint32_t DeviceThreadController::send(Request::Type type, const QByteArray& data, int baud_rate) {
+		QMutexLocker locker(&mutex_);
+		uint32_t id = ++last_id_;
+		requests_.enqueue({ type, id, data, baud_rate });
+		if (!isRunning()) {
+			start();
+		}
+		wake_condition_.wakeAll();
+		return id;
+	}
+
+	/**
+	 * Records an error message.
+	 * @param error Error message.
+	 */
+	void DeviceThreadController::set_error(const QString& error) {
+		QMutexLocker locker(&mutex_);
+		error_ = error;
+	}
+
+	/**
+	 * Stops the thread and waits for it to finish.
+	 * The device is closed, and anything still in the queue is dropped.
+	 */
+	void DeviceThreadController::stop() {
+		{
+			QMutexLocker locker(&mutex_);
+			requestInterruption();
+			wake_condition_.wakeAll();
+		}
+		wait();
+	}
+
+	/**
+	 * Queues data to write to the device.
+	 * The data is copied, so the caller is free to change or discard it.
+	 * @param data Data to write.
+	 * @return ID used in progress_changed() and write_finished().
+	 */
+	uint32_t DeviceThreadController::write(const QByteArray& data) {
+		statistics_->pending_writes.fetch_add(1, std::memory_order_relaxed);
+		return send(Request::Type::Write, data);
+	}
+
+	/**
+	 * Writes data to the device in chunks (runs on the thread).
+	 * @param request Write request.
+	 */
+	void DeviceThreadController::write_data(const Request& request) {
+		TraceRecorder::Span span("DeviceThreadController::write_data");
+		PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::DeviceWrite);
+		emit progress_changed(request.id, 0);
+
+		const QByteArray& output = request.data;
+		bool completed = open_;
 		int current_index = 0;
-		int chunk_index = CHUNK_SIZE;
+		int progress = 0;
+		while (completed && current_index < output.size()) {
+			if (get_cancelled(request.id) || isInterruptionRequested()) {
+				completed = false;
+				break;
+			}
 
-		do {
-			if (current_index > 0) {
+			if (current_index > 0 && SLEEP_INTERVAL > 0) {
 				msleep(SLEEP_INTERVAL);
 			}
 
-			QByteArray out_addr = output_.mid(current_index, chunk_index);
+			qint64 written = device_->write(output.constData() + current_index, qMin(static_cast<int>(CHUNK_SIZE), output.size() - current_index));
+			if (written < 0) {
+				set_error(device_->errorString());
+				completed = false;
+				break;
+			}
+			device_->waitForBytesWritten(DeviceController::TIMEOUT);
+
+			statistics_->bytes_written.fetch_add(static_cast<uint64_t>(written), std::memory_order_relaxed);
+			current_index += static_cast<int>(written);
 
-			if (current_index + chunk_index > output_.size()) {
-				chunk_index = output_.size() - current_index;
+			// Only report whole percentages to avoid flooding the UI with signals
+			int new_progress = static_cast<int>((current_index / static_cast<float>(output.size())) * 100);
+			if (new_progress != progress) {
+				progress = new_progress;
+				emit progress_changed(request.id, progress);
 			}
-			device_.get_device()->write(out_addr);
-			device_.flush();
-			current_index += chunk_index;
-			emit progress_changed((current_index / (float)output_.size()) * 100);
 		}
-		while (current_index < output_.size());
 
-		emit progress_changed(100);
+		bool was_open = open_;
+		open_ = get_connected();
+		statistics_->pending_writes.fetch_sub(1, std::memory_order_relaxed);
+		emit write_finished(request.id, completed);
+
+		// The connection dropped during the write
+		if (was_open && !open_) {
+			emit disconnected();
+		}
+	}
+
+	DeviceThreadController::~DeviceThreadController() {
+		stop();
 	}
 }
@@ -1,8 +1,22 @@
+/*
+ * DeviceThreadController - Long-lived I/O thread belonging to a single device.
+ * The device is opened, written to, and closed on this thread only, so the UI never waits on a slow device. Requests are queued and run in order, and their results are reported through signals. Writes are queued as immutable buffers, and can be cancelled individually.
+ */
+
 #ifndef SERIALDEVICETHREAD_H
 #define SERIALDEVICETHREAD_H
 
 #include <QByteArray>
+#include <QIODevice>
+#include <QMutex>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QSet>
+#include <QSharedPointer>
+#include <QString>
 #include <QThread>
+#include <QWaitCondition>
+#include <atomic>
 #include "devicecontroller.h"
 
 namespace PixelMaestroStudio {
@@ -10,21 +24,113 @@ namespace PixelMaestroStudio {
 		Q_OBJECT
 
 		public:
-			DeviceThreadController(DeviceController& device, const char* out, int size);
+			explicit DeviceThreadController(QSharedPointer<DeviceController::Statistics> statistics);
+			~DeviceThreadController();
+			void cancel(uint32_t write_id);
+			void close_device();
+			QString get_error() const;
+			bool get_open() const;
+			void open_device(const QString& port_name, int baud_rate);
 			void run() override;
+			void stop();
+			uint32_t write(const QByteArray& data);
 
 		signals:
-			void progress_changed(int progress);
+			/**
+			 * Reports that the device was opened.
+			 */
+			void connected();
+
+			/**
+			 * Reports that the device was closed, either on request or because the connection dropped.
+			 */
+			void disconnected();
+
+			/**
+			 * Reports that the device couldn't be opened, or couldn't finish writing before it was closed.
+			 * @param error Description of the error.
+			 */
+			void error(const QString& error);
+
+			/**
+			 * Reports how much of a write has reached the device.
+			 * @param write_id Write returned by write().
+			 * @param progress Percentage sent.
+			 */
+			void progress_changed(uint32_t write_id, int progress);
+
+			/**
+			 * Reports that a write is done.
+			 * @param write_id Write returned by write().
+			 * @param completed True if every byte was sent, false if the write was cancelled or failed.
+			 */
+			void write_finished(uint32_t write_id, bool completed);
 
 		private:
+			/// A job for the thread.
+			struct Request {
+				enum class Type {
+					Open,
+					Close,
+					Write
+				};
+
+				/// What to do.
+				Type type;
+
+				/// Identifies the request.
+				uint32_t id;
+
+				/// Bytes to write, or the port to open.
+				QByteArray data;
+
+				/// Baud rate to open serial ports with.
+				int baud_rate;
+			};
+
 			/// Size of each chunk in bytes
 			const uint8_t CHUNK_SIZE = 64;
 
 			/// Time in milliseconds between chunks. Disabled by default.
 			const uint8_t SLEEP_INTERVAL = 0;
 
-			DeviceController& device_;
-			QByteArray output_;
+			/// Writes that were cancelled before they finished.
+			QSet<uint32_t> cancelled_ids_;
+
+			/// The device. Only touched from this thread.
+			QScopedPointer<QIODevice> device_;
+
+			/// Description of the last error.
+			QString error_;
+
+			/// The ID of the most recently finished request. Requests finish in the order they were sent.
+			uint32_t finished_id_ = 0;
+
+			/// The ID of the most recent request.
+			uint32_t last_id_ = 0;
+
+			/// Guards the request queue, cancelled writes, and error.
+			mutable QMutex mutex_;
+
+			/// Whether the device is connected.
+			std::atomic<bool> open_{false};
+
+			/// Requests waiting to run.
+			QQueue<Request> requests_;
+
+			/// Traffic counters shared with the DeviceController.
+			QSharedPointer<DeviceController::Statistics> statistics_;
+
+			/// Wakes the thread when a request arrives.
+			QWaitCondition wake_condition_;
+
+			void close();
+			bool get_cancelled(uint32_t write_id) const;
+			bool get_connected() const;
+			bool open(const QString& port_name, int baud_rate);
+			uint32_t send(Request::Type type, const QByteArray& data = QByteArray(), int baud_rate = 0);
+			void set_error(const QString& error);
+			void write_data(const Request& request);
 	};
 }
 
@@ -0,0 +1,118 @@
+#include <QtGlobal>
+#include "animation/animation.h"
+#include "canvas/canvas.h"
+#include "core/timer/animationtimer.h"
+#include "core/timer/timer.h"
+#include "cue/event.h"
+#include "cue/show.h"
+#include "idlescheduler.h"
+
+namespace PixelMaestroStudio {
+	const uint64_t IdleScheduler::NEVER;
+
+	/**
+	 * Returns the time of the next update that can change the Maestro's output.
+	 * Updates are never closer together than the Maestro's refresh interval, so this is at least one interval away.
+	 * @param maestro Maestro to check.
+	 * @param current_time Current Maestro time.
+	 * @return Time of the next update, or NEVER if the output won't change on its own.
+	 */
+	uint64_t IdleScheduler::get_next_update_time(Maestro& maestro, uint64_t current_time) {
+		uint64_t until_change = get_time_until_change(maestro, current_time);
+		if (until_change == NEVER) return NEVER;
+
+		return current_time + qMax<uint64_t>(until_change, maestro.get_timer().get_interval());
+	}
+
+	/**
+	 * Returns the time remaining until a deadline.
+	 * @param deadline Deadline in Maestro time.
+	 * @param current_time Current Maestro time.
+	 * @return Time until the deadline, or 0 if it already passed.
+	 */
+	uint64_t IdleScheduler::get_time_until(uint64_t deadline, uint64_t current_time) {
+		return (deadline > current_time) ? deadline - current_time : 0;
+	}
+
+	/**
+	 * Returns how long the Maestro's output is guaranteed to stay the same, assuming no Cues are run in the meantime.
+	 * @param maestro Maestro to check.
+	 * @param current_time Current Maestro time.
+	 * @return Time until the output can change. 0 if it can change on the next update, or NEVER if it won't change on its own.
+	 */
+	uint64_t IdleScheduler::get_time_until_change(Maestro& maestro, uint64_t current_time) {
+		uint64_t until_change = NEVER;
+
+		// Check when the next Show Event runs
+		Show* show = maestro.get_show();
+		if (show != nullptr && show->get_num_events() > 0) {
+			if (show->get_current_index() < show->get_num_events()) {
+				Event* event = show->get_event_at_index(show->get_current_index());
+				uint64_t deadline = event->get_time();
+				if (show->get_timing() == Show::TimingMode::Relative) {
+					deadline += show->get_last_time();
+				}
+				until_change = get_time_until(deadline, current_time);
+			}
+			else if (show->get_looping()) {
+				// Looping Shows restart as soon as the last Event runs
+				return 0;
+			}
+		}
+
+		for (uint8_t section = 0; section < maestro.get_num_sections() && until_change > 0; section++) {
+			until_change = qMin(until_change, get_time_until_change(*maestro.get_section(section), current_time));
+		}
+
+		return until_change;
+	}
+
+	/**
+	 * Returns how long a Section and its Layers are guaranteed to stay the same.
+	 * Each part of the Section that changes over time is driven by a Timer, and can't change until that Timer's next tick:
+	 * - Animations redraw when their timer ticks. While fading, the Pixels also move toward their next color on every update.
+	 * - Scrolling moves the Section when the axis' timer ticks. Fast scrolls that step on every update don't use a timer.
+	 * - Canvases change when their frame timer advances to the next frame.
+	 * Stopped timers are treated as due, so a paused Animation or Canvas is checked on every update.
+	 * @param section Section to check.
+	 * @param current_time Current Maestro time.
+	 * @return Time until the Section can change, or NEVER if it won't change on its own.
+	 */
+	uint64_t IdleScheduler::get_time_until_change(Section& section, uint64_t current_time) {
+		uint64_t until_change = NEVER;
+
+		Animation* animation = section.get_animation();
+		if (animation != nullptr) {
+			if (animation->get_fade()) {
+				return 0;
+			}
+			until_change = get_time_until(animation->get_timer()->get_last_time() + animation->get_timer()->get_interval(), current_time);
+		}
+
+		Section::Scroll* scroll = section.get_scroll();
+		if (scroll != nullptr) {
+			if (scroll->step_x > 0 || scroll->step_y > 0) {
+				return 0;
+			}
+			if (scroll->timer_x != nullptr) {
+				until_change = qMin(until_change, get_time_until(scroll->timer_x->get_last_time() + scroll->timer_x->get_interval(), current_time));
+			}
+			if (scroll->timer_y != nullptr) {
+				until_change = qMin(until_change, get_time_until(scroll->timer_y->get_last_time() + scroll->timer_y->get_interval(), current_time));
+			}
+		}
+
+		Canvas* canvas = section.get_canvas();
+		if (canvas != nullptr && canvas->get_num_frames() > 1 && canvas->get_frame_timer() != nullptr) {
+			Timer* timer = canvas->get_frame_timer();
+			until_change = qMin(until_change, get_time_until(timer->get_last_time() + timer->get_interval(), current_time));
+		}
+
+		Section::Layer* layer = section.get_layer();
+		if (until_change > 0 && layer != nullptr && layer->section != nullptr) {
+			until_change = qMin(until_change, get_time_until_change(*layer->section, current_time));
+		}
+
+		return until_change;
+	}
+}
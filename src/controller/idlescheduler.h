@@ -0,0 +1,29 @@
+/*
+ * IdleScheduler - Determines when a Maestro's output will next change, so that updates can be skipped until then.
+ */
+
+#ifndef IDLESCHEDULER_H
+#define IDLESCHEDULER_H
+
+#include <stdint.h>
+#include "core/maestro.h"
+#include "core/section.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class IdleScheduler {
+		public:
+			/// Returned when the output won't change until the Maestro is modified.
+			static const uint64_t NEVER = UINT64_MAX;
+
+			static uint64_t get_next_update_time(Maestro& maestro, uint64_t current_time);
+			static uint64_t get_time_until_change(Maestro& maestro, uint64_t current_time);
+			static uint64_t get_time_until_change(Section& section, uint64_t current_time);
+
+		private:
+			static uint64_t get_time_until(uint64_t deadline, uint64_t current_time);
+	};
+}
+
+#endif // IDLESCHEDULER_H
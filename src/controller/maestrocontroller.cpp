@@ -1,21 +1,17 @@
-#include "animation/fireanimation.h"
-#include "animation/lightninganimation.h"
-#include "animation/plasmaanimation.h"
-#include "animation/radialanimation.h"
-#include "animation/sparkleanimation.h"
-#include "animation/waveanimation.h"
-#include "canvas/canvas.h"
 #include "core/maestro.h"
-#include "cue/animationcuehandler.h"
-#include "cue/canvascuehandler.h"
-#include "cue/maestrocuehandler.h"
-#include "cue/sectioncuehandler.h"
-#include "cue/show.h"
-#include "cue/showcuehandler.h"
+#include "idlescheduler.h"
 #include "maestrocontroller.h"
+#include <climits>
 #include <QByteArray>
+#include <QGuiApplication>
+#include <QMutexLocker>
+#include <QScreen>
 #include <QSettings>
 #include "dialog/preferencesdialog.h"
+#include "utility/cuefileencoder.h"
+#include "utility/cuefileutility.h"
+#include "utility/performancemonitor.h"
+#include "utility/tracerecorder.h"
 
 using namespace PixelMaestro;
 
@@ -24,12 +20,27 @@ namespace PixelMaestroStudio {
 	 * Initializes the MaestroController.
 	 * @param maestro_control_widget The widget responsible for controlling this MaestroController.
 	 */
-	MaestroController::MaestroController(MaestroControlWidget& maestro_control_widget) : timer_(this), maestro_control_widget_(maestro_control_widget) {
+	MaestroController::MaestroController(MaestroControlWidget& maestro_control_widget) : timer_(this), render_timer_(this), idle_timer_(this), maestro_control_widget_(maestro_control_widget) {
+		QSettings settings;
+		if (settings.value(PreferencesDialog::simulation_thread, false).toBool()) {
+			simulation_thread_ = new SimulationThreadController(*this);
+		}
+		hidden_interval_ = static_cast<uint16_t>(settings.value(PreferencesDialog::hidden_refresh_rate, 0).toInt());
+		section_updater_.set_parallel(settings.value(PreferencesDialog::parallel_sections, false).toBool());
+
 		initialize_maestro();
 
 		// Initialize timers
 		timer_.setTimerType(Qt::PreciseTimer);
 		connect(&timer_, SIGNAL(timeout()), this, SLOT(update()));
+		render_timer_.setTimerType(Qt::PreciseTimer);
+		connect(&render_timer_, SIGNAL(timeout()), this, SLOT(render()));
+		idle_timer_.setSingleShot(true);
+		connect(&idle_timer_, SIGNAL(timeout()), this, SLOT(resume()));
+
+		if (simulation_thread_ != nullptr) {
+			connect(simulation_thread_, SIGNAL(resumed()), this, SLOT(resume()));
+		}
 	}
 
 	/**
@@ -38,14 +49,107 @@ namespace PixelMaestroStudio {
 	 */
 	void MaestroController::add_drawing_area(MaestroDrawingArea& drawing_area) {
 		drawing_areas_.push_back(&drawing_area);
+		connect(&drawing_area, SIGNAL(exposed_changed(bool)), this, SLOT(update_visibility()));
+		update_visibility();
 
 		// Initialize the DrawingArea's SectionDrawingAreas
 		for (uint8_t section = 0; section < this->num_sections_; section++) {
 			drawing_area.add_section_drawing_area(sections_[section], section);
 		}
+	}
+
+	/**
+	 * Simulates the Maestro forward in time as fast as possible instead of waiting on the clock.
+	 * The time source is moved forward by the same amount, so playback continues from the new time.
+	 * Combined with a VirtualTimeSource, this produces the same output on every run.
+	 * @param duration Amount of Maestro time to simulate in milliseconds.
+	 * @param step Time between updates. If 0, skips straight to each update that can change the output.
+	 * @return The number of updates run.
+	 */
+	uint32_t MaestroController::advance(uint64_t duration, uint16_t step) {
+		uint32_t num_updates = 0;
+		{
+			QMutexLocker locker(get_maestro_mutex());
+			uint64_t time = time_source_->get_time();
+			uint64_t end = time + duration;
+			while (time < end) {
+				uint64_t next = (step > 0) ? time + step : IdleScheduler::get_next_update_time(*maestro_, time);
+				if (next > end) break;
+
+				time = next;
+				{
+					TraceRecorder::Span span("MaestroController::advance");
+					PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::Update);
+					section_updater_.update(*maestro_, time, true);
+				}
+				num_updates++;
+			}
+			time_source_->set_time(end);
+			PerformanceMonitor::increment(PerformanceMonitor::Counter::FramesSimulated, num_updates);
+
+			if (simulation_thread_ != nullptr) {
+				simulation_thread_->publish_frame();
+			}
+		}
+
+		// An idle Maestro only wakes on the wall clock when running in real time, so wake it here
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->wake();
+		}
+		frame_sequence_++;
+		frame_pending_ = true;
+		last_update_time_ = 0;
+		render();
+		resume();
+
+		return num_updates;
+	}
+
+	/**
+	 * Returns the Maestro's current output.
+	 * The frame is captured at most once per Maestro update and shared by every caller.
+	 * If the Maestro runs on a separate thread, this returns the latest frame published by the thread.
+	 * @return Latest frame.
+	 */
+	const MaestroFrame* MaestroController::get_frame() {
+		if (simulation_thread_ != nullptr) {
+			return &simulation_thread_->get_frames().get_front();
+		}
+
+		if (frame_.get_sequence() != frame_sequence_) {
+			frame_.capture(*maestro_, frame_sequence_);
+		}
+
+		return &frame_;
+	}
+
+	/**
+	 * Returns the user's default Maestro refresh interval.
+	 * Saved Cuefiles only include the Maestro's timer if it differs from this.
+	 * @return Refresh interval in milliseconds.
+	 */
+	uint16_t MaestroController::get_default_interval() {
+		QSettings settings;
+		return static_cast<uint16_t>(settings.value(PreferencesDialog::refresh_rate, QVariant(50)).toInt());
+	}
+
+	/**
+	 * Returns the time between preview redraws.
+	 * This is either the user's preview frame rate or the display's refresh rate, but never faster than the Maestro's refresh rate.
+	 * @return Redraw interval in milliseconds.
+	 */
+	int MaestroController::get_render_interval() {
+		QSettings settings;
+		int frame_rate = settings.value(PreferencesDialog::preview_frame_rate, 0).toInt();
+		if (frame_rate <= 0) {
+			QScreen* screen = QGuiApplication::primaryScreen();
+			frame_rate = (screen != nullptr) ? qRound(screen->refreshRate()) : 60;
+		}
+
+		int interval = 1000 / qMax(frame_rate, 1);
 
-		// Refresh the DrawingArea on each timeout
-		connect(&timer_, SIGNAL(timeout()), &drawing_area, SLOT(update()));
+		// Redrawing faster than the Maestro updates would only redraw the same frame
+		return qMax(interval, static_cast<int>(maestro_->get_timer().get_interval()));
 	}
 
 	/**
@@ -56,12 +160,32 @@ namespace PixelMaestroStudio {
 		return *maestro_.data();
 	}
 
+	/**
+	 * Returns the mutex that must be held while reading the Maestro from the UI thread.
+	 * @return Maestro mutex, or null if the Maestro is updated on the UI thread.
+	 */
+	QMutex* MaestroController::get_maestro_mutex() {
+		if (simulation_thread_ == nullptr) {
+			return nullptr;
+		}
+
+		return simulation_thread_->get_mutex();
+	}
+
+	/**
+	 * Returns whether the Maestro's time follows the wall clock.
+	 * @return True if the time source is a RealTimeSource.
+	 */
+	bool MaestroController::get_real_time() const {
+		return dynamic_cast<RealTimeSource*>(time_source_.data()) != nullptr;
+	}
+
 	/**
 	 * Returns whether the Maestro is running.
 	 * @return True if Maestro is running.
 	 */
 	bool MaestroController::get_running() {
-		return timer_.isActive();
+		return running_;
 	}
 
 	/**
@@ -69,19 +193,58 @@ namespace PixelMaestroStudio {
 	 * @return Total elapsed time.
 	 */
 	uint64_t MaestroController::get_total_elapsed_time() {
-		uint64_t elapsed = last_pause_;
+		return time_source_->get_time();
+	}
 
-		if (get_running()) {
-			elapsed += elapsed_timer_.elapsed();
-		}
+	/**
+	 * Returns the source of the Maestro's runtime.
+	 * @return Time source.
+	 */
+	TimeSource& MaestroController::get_time_source() {
+		return *time_source_;
+	}
+
+	/**
+	 * Returns the incrementally maintained Cuefile.
+	 * The cache's default refresh interval is updated from the user's Preferences first, since they may have changed since the Maestro was initialized.
+	 * @return Cuefile cache.
+	 */
+	CuefileCache& MaestroController::get_cuefile_cache() {
+		cuefile_cache_.set_default_interval(get_default_interval());
+		return cuefile_cache_;
+	}
 
-		return elapsed;
+	/**
+	 * Returns the object that runs each Maestro update.
+	 * @return Section updater.
+	 */
+	SectionUpdater& MaestroController::get_section_updater() {
+		return section_updater_;
+	}
+
+	/**
+	 * Returns the time between Maestro updates.
+	 * While every DrawingArea is hidden, this switches to the hidden refresh interval if one is set.
+	 * @return Update interval in milliseconds.
+	 */
+	uint16_t MaestroController::get_update_interval() const {
+		uint16_t interval = maestro_->get_timer().get_interval();
+		if (hidden_ && hidden_interval_ > interval) {
+			return hidden_interval_;
+		}
+		return interval;
 	}
 
 	/**
 	 * Resets the Maestro.
 	 */
 	void MaestroController::initialize_maestro() {
+		// Stop the simulation thread and any Cuefile updates before touching the Maestro
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->stop();
+		}
+		cuefile_cache_.wait();
+
 		if (!maestro_.isNull()) {
 			maestro_.reset();
 		}
@@ -99,12 +262,14 @@ namespace PixelMaestroStudio {
 		maestro_->set_timer(refresh);
 
 		// Enable the Maestro's CueController and CueHandlers
-		CueController& controller = maestro_->set_cue_controller(UINT16_MAX);
-		controller.enable_animation_cue_handler();
-		controller.enable_canvas_cue_handler();
-		controller.enable_maestro_cue_handler();
-		controller.enable_section_cue_handler();
-		controller.enable_show_cue_handler();
+		CuefileUtility::initialize_cue_controller(*maestro_);
+
+		cuefile_cache_.set_maestro(*maestro_, get_maestro_mutex());
+		cuefile_cache_.set_default_interval(get_default_interval());
+
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->start();
+		}
 	}
 
 	/**
@@ -112,193 +277,136 @@ namespace PixelMaestroStudio {
 	 * @param drawing_area DrawingArea to remove.
 	 */
 	void MaestroController::remove_drawing_area(MaestroDrawingArea& drawing_area) {
-		disconnect(&timer_, SIGNAL(timeout()), &drawing_area, SLOT(update()));
 		drawing_areas_.removeOne(&drawing_area);
+		disconnect(&drawing_area, SIGNAL(exposed_changed(bool)), this, SLOT(update_visibility()));
+		update_visibility();
 	}
 
 	/**
-	 * Saves Maestro settings to a DataStream as Cues.
-	 * @param datastream Stream to save Cues to.
-	 * @param save_handlers CueHandlers that are enabled for saving.
+	 * Redraws each DrawingArea if the Maestro produced a new frame since the last redraw.
+	 * Frames that were produced and replaced between redraws are never drawn.
 	 */
-	void MaestroController::save_maestro_to_datastream(QDataStream& datastream, QVector<CueController::Handler>* save_handlers) {
-		MaestroCueHandler* maestro_handler = dynamic_cast<MaestroCueHandler*>(maestro_->get_cue_controller().get_handler(CueController::Handler::MaestroCueHandler));
-
-		// Maestro-specific Cues
-		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::MaestroCueHandler)) {
-			QSettings settings;
-			uint16_t interval = static_cast<uint16_t>(settings.value(PreferencesDialog::refresh_rate, 50).toUInt());
-			if (maestro_->get_timer().get_interval() != interval) {
-				write_cue_to_stream(datastream, maestro_handler->set_timer(interval));
-			}
+	void MaestroController::render() {
+		if (simulation_thread_ != nullptr && simulation_thread_->get_frames().consume()) {
+			frame_pending_ = true;
 		}
 
-		// Show-specific Cues
-		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::ShowCueHandler)) {
-			Show* show = maestro_->get_show();
-			if (show != nullptr) {
-				write_cue_to_stream(datastream, maestro_handler->set_show());
-
-				ShowCueHandler* show_handler = dynamic_cast<ShowCueHandler*>(maestro_->get_cue_controller().get_handler(CueController::Handler::ShowCueHandler));
-				write_cue_to_stream(datastream, show_handler->set_looping(show->get_looping()));
-				write_cue_to_stream(datastream, show_handler->set_timing_mode(show->get_timing()));
-
-				// Save events for last until I can nail down the byte alignment issues with event Cues
-				if (show->get_events() != nullptr) {
-					write_cue_to_stream(datastream, show_handler->set_events(show->get_events(), show->get_num_events(), false));
-				}
+		if (!frame_pending_) {
+			// Once the last frame before going idle is drawn, stop redrawing until the Maestro resumes
+			bool idle = (simulation_thread_ != nullptr) ? simulation_thread_->get_idle() : idle_;
+			if (idle) {
+				render_timer_.stop();
 			}
+			return;
 		}
+		frame_pending_ = false;
+		PerformanceMonitor::increment(PerformanceMonitor::Counter::FramesPresented);
 
-		// Save Sections
-		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::SectionCueHandler)) {
-			for (uint8_t section = 0; section < num_sections_; section++) {
-				save_section_to_datastream(datastream, section, 0, save_handlers);
+		for (MaestroDrawingArea* drawing_area : drawing_areas_) {
+			if (drawing_area->get_exposed()) {
+				drawing_area->update();
 			}
 		}
 	}
 
 	/**
-	 * Saves Section settings to a DataStream as Cues.
-	 * @param datastream Stream to save Cues to.
-	 * @param section_id The index of the Section to save.
-	 * @param layer_id The index of the Layer to save.
-	 * @param save_handlers CueHandlers that are enabled for saving. If null, save all Cues
+	 * Wakes the Maestro from idle.
+	 * Called when an idle period ends or when a Cue might have changed the output.
 	 */
-	void MaestroController::save_section_to_datastream(QDataStream& datastream, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers) {
+	void MaestroController::resume() {
+		section_updater_.invalidate();
+		if (!running_) return;
 
-		Section* section = maestro_->get_section(section_id);
-		if (section == nullptr) return;
+		idle_timer_.stop();
+		idle_ = false;
+		last_update_time_ = 0;
 
-		if (layer_id > 0) {
-			for (uint8_t i = 0; i < layer_id; i++) {
-				section = section->get_layer()->section;
-			}
+		if (simulation_thread_ == nullptr && !timer_.isActive()) {
+			timer_.start(get_update_interval());
 		}
-
-		SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(maestro_->get_cue_controller().get_handler(CueController::Handler::SectionCueHandler));
-
-		// Global Section settings
-		if (section->get_brightness() != 255) {
-			write_cue_to_stream(datastream, section_handler->set_brightness(section_id, layer_id, section->get_brightness()));
+		if (!hidden_ && !render_timer_.isActive()) {
+			render_timer_.start(render_interval_);
 		}
+	}
 
-		// Only set dimensions for Sections, not Layers
-		if (layer_id == 0) {
-			write_cue_to_stream(datastream, section_handler->set_dimensions(section_id, layer_id, section->get_dimensions().x, section->get_dimensions().y));
+	/**
+	 * Runs a Cue on the Maestro.
+	 * If the Maestro is updated on a separate thread, the Cue is sent to that thread.
+	 * @param cue Cue to run.
+	 */
+	void MaestroController::run_cue(uint8_t* cue) {
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->queue_cue(cue, maestro_->get_cue_controller().get_cue_size(cue));
 		}
+		else {
+			maestro_->get_cue_controller().run(cue);
+			PerformanceMonitor::increment(PerformanceMonitor::Counter::CuesRun);
+			frame_sequence_++;
+		}
+		cuefile_cache_.invalidate(cue);
 
-		// Animation & Colors
-		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::AnimationCueHandler)) {
-			Animation* animation = section->get_animation();
-			if (animation != nullptr) {
-				write_cue_to_stream(datastream, section_handler->set_animation(section_id, layer_id, animation->get_type()));
-
-				AnimationCueHandler* animation_handler = dynamic_cast<AnimationCueHandler*>(maestro_->get_cue_controller().get_handler(CueController::Handler::AnimationCueHandler));
-				if (animation->get_palette() != nullptr) {
-					write_cue_to_stream(datastream, animation_handler->set_palette(section_id, layer_id, *animation->get_palette()));
-				}
-				write_cue_to_stream(datastream, animation_handler->set_center(section_id, layer_id, animation->get_center().x, animation->get_center().y));
-				write_cue_to_stream(datastream, animation_handler->set_orientation(section_id, layer_id, animation->get_orientation()));
-				write_cue_to_stream(datastream, animation_handler->set_reverse(section_id, layer_id, animation->get_reverse()));
-				write_cue_to_stream(datastream, animation_handler->set_fade(section_id, layer_id, animation->get_fade()));
+		resume();
+	}
 
-				if (animation->get_timer() != nullptr) {
-					write_cue_to_stream(datastream, animation_handler->set_timer(section_id, layer_id, animation->get_timer()->get_interval(), animation->get_timer()->get_delay()));
+	/**
+	 * Runs every Cue in a Cuefile on the Maestro in one batch.
+	 * The Maestro is locked once for the whole file, and the Cuefile, idle state, and frame are only updated once at the end.
+	 * @param cuefile Contents of the Cuefile.
+	 * @param show_cues_only If true, only Show Cues are run. Used while the Maestro is locked.
+	 * @return The number of Cues run.
+	 */
+	uint32_t MaestroController::run_cuefile(const QByteArray& cuefile, bool show_cues_only) {
+		TraceRecorder::Span span("MaestroController::run_cuefile");
+		uint32_t num_cues = 0;
+		{
+			QMutexLocker locker(get_maestro_mutex());
+			CueController& controller = maestro_->get_cue_controller();
+			CuefileUtility::read_cuefile(cuefile, [&](uint8_t* cue) {
+				if (show_cues_only && cue[static_cast<uint8_t>(CueController::Byte::PayloadByte)] != static_cast<uint8_t>(CueController::Handler::ShowCueHandler)) {
+					return;
 				}
+				controller.run(cue);
+				num_cues++;
+			});
 
-				// Save Animation-specific settings
-				switch(animation->get_type()) {
-					case AnimationType::Fire:
-						{
-							FireAnimation* fa = dynamic_cast<FireAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_fire_options(section_id, layer_id, fa->get_multiplier()));
-						}
-						break;
-					case AnimationType::Lightning:
-						{
-							LightningAnimation* la = dynamic_cast<LightningAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_lightning_options(section_id, layer_id, la->get_bolt_count(), la->get_drift(), la->get_fork_chance()));
-						}
-						break;
-					case AnimationType::Plasma:
-						{
-							PlasmaAnimation* pa = dynamic_cast<PlasmaAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_plasma_options(section_id, layer_id, pa->get_size(), pa->get_resolution()));
-						}
-						break;
-					case AnimationType::Radial:
-						{
-							RadialAnimation* ra = dynamic_cast<RadialAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_radial_options(section_id, layer_id, ra->get_resolution()));
-						}
-						break;
-					case AnimationType::Sparkle:
-						{
-							SparkleAnimation* sa = dynamic_cast<SparkleAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_sparkle_options(section_id, layer_id, sa->get_threshold()));
-						}
-						break;
-					case AnimationType::Wave:
-						{
-							WaveAnimation* wa = dynamic_cast<WaveAnimation*>(animation);
-							write_cue_to_stream(datastream, animation_handler->set_wave_options(section_id, layer_id, wa->get_skew()));
-						}
-						break;
-					default:
-						break;
-				}
+			if (simulation_thread_ != nullptr) {
+				simulation_thread_->publish_frame();
 			}
 		}
+		PerformanceMonitor::increment(PerformanceMonitor::Counter::CuesRun, num_cues);
 
-		// Scrolling, offset, mirroring, wrap
-		Point& offset = section->get_offset();
-		if (offset.x != 0 || offset.y != 0) {
-			write_cue_to_stream(datastream, section_handler->set_offset(section_id, layer_id, offset.x, offset.y));
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->wake();
 		}
-		Section::Scroll* scroll = section->get_scroll();
-		if (scroll != nullptr) {
-			write_cue_to_stream(datastream, section_handler->set_scroll(section_id, layer_id, scroll->interval_x, scroll->interval_y, scroll->reverse_x, scroll->reverse_y));
-		}
-		Section::Mirror* mirror = section->get_mirror();
-		if (mirror != nullptr) {
-			write_cue_to_stream(datastream, section_handler->set_mirror(section_id, layer_id, mirror->x, mirror->y));
-		}
-		bool wrap = section->get_wrap();
-		if (wrap == false) {
-			write_cue_to_stream(datastream, section_handler->set_wrap(section_id, layer_id, wrap));
-		}
-
-		// Save Canvas settings
-		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::CanvasCueHandler)) {
-			Canvas* canvas = section->get_canvas();
-			if (canvas != nullptr) {
-				write_cue_to_stream(datastream, section_handler->set_canvas(section_id, layer_id, canvas->get_num_frames()));
-
-				CanvasCueHandler* canvas_handler = dynamic_cast<CanvasCueHandler*>(maestro_->get_cue_controller().get_handler(CueController::Handler::CanvasCueHandler));
+		cuefile_cache_.invalidate();
+		frame_sequence_++;
+		frame_pending_ = true;
+		resume();
 
-				if (canvas->get_frame_timer()) {
-					write_cue_to_stream(datastream, canvas_handler->set_frame_timer(section_id, layer_id, canvas->get_frame_timer()->get_interval()));
-				}
+		return num_cues;
+	}
 
-				if (canvas->get_palette() != nullptr) {
-					write_cue_to_stream(datastream, canvas_handler->set_palette(section_id, layer_id, *canvas->get_palette()));
-				}
+	/**
+	 * Saves Maestro settings to a DataStream as Cues.
+	 * @param datastream Stream to save Cues to.
+	 * @param save_handlers CueHandlers that are enabled for saving.
+	 */
+	void MaestroController::save_maestro_to_datastream(QDataStream& datastream, QVector<CueController::Handler>* save_handlers) {
+		TraceRecorder::Span span("MaestroController::save_maestro_to_datastream");
+		QMutexLocker locker(get_maestro_mutex());
 
-				// Draw and save each frame
-				for (uint16_t frame = 0; frame < canvas->get_num_frames(); frame++) {
-					write_cue_to_stream(datastream, canvas_handler->draw_frame(section_id, layer_id, frame, section->get_dimensions().x, section->get_dimensions().y, canvas->get_frame(frame)));
-				}
-				write_cue_to_stream(datastream, canvas_handler->set_current_frame_index(section_id, layer_id, canvas->get_current_frame_index()));
-			}
-		}
+		CuefileEncoder::save_maestro(datastream, *maestro_, get_default_interval(), save_handlers);
+	}
 
-		// Layers
-		Section::Layer* layer = section->get_layer();
-		if (layer != nullptr) {
-			write_cue_to_stream(datastream, section_handler->set_layer(section_id, layer_id, layer->mix_mode, layer->alpha));
-			save_section_to_datastream(datastream, section_id, layer_id + 1, save_handlers);
-		}
+	/**
+	 * Saves Section settings to a DataStream as Cues.
+	 * @param datastream Stream to save Cues to.
+	 * @param section_id The index of the Section to save.
+	 * @param layer_id The index of the Layer to save. Every Layer above it is also saved.
+	 * @param save_handlers CueHandlers that are enabled for saving. If null, save all Cues
+	 */
+	void MaestroController::save_section_to_datastream(QDataStream& datastream, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers) {
+		CuefileEncoder::save_section(datastream, *maestro_, maestro_->get_cue_controller(), section_id, layer_id, save_handlers);
 	}
 
 	/**
@@ -318,6 +426,9 @@ namespace PixelMaestroStudio {
 		}
 
 		maestro_->set_sections(sections_, num_sections_);
+		cuefile_cache_.invalidate();
+		frame_sequence_++;
+		resume();
 
 		// Reset each drawing area's Sections
 		for (MaestroDrawingArea* drawing_area : this->drawing_areas_) {
@@ -332,18 +443,127 @@ namespace PixelMaestroStudio {
 		return this->sections_;
 	}
 
+	/**
+	 * Replaces the source of the Maestro's runtime.
+	 * The new source continues from the current time.
+	 * @param time_source New time source. The MaestroController takes ownership of it.
+	 */
+	void MaestroController::set_time_source(TimeSource* time_source) {
+		{
+			QMutexLocker locker(get_maestro_mutex());
+			time_source->set_time(time_source_->get_time());
+			if (running_) {
+				time_source->start();
+			}
+			time_source_ = QSharedPointer<TimeSource>(time_source);
+		}
+
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->wake();
+		}
+		resume();
+	}
+
 	void MaestroController::start() {
-		elapsed_timer_.restart();
-		timer_.start(this->maestro_->get_timer().get_interval());
+		{
+			QMutexLocker locker(get_maestro_mutex());
+			time_source_->start();
+			running_ = true;
+		}
+
+		// If the Maestro runs on its own thread, the thread handles its own timing
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->wake();
+		}
+		else {
+			timer_.start(get_update_interval());
+		}
+
+		idle_ = false;
+		last_update_time_ = 0;
+		render_interval_ = get_render_interval();
+		if (!hidden_) {
+			render_timer_.start(render_interval_);
+		}
 	}
 
 	void MaestroController::stop() {
-		last_pause_ += elapsed_timer_.elapsed();
+		{
+			QMutexLocker locker(get_maestro_mutex());
+			time_source_->stop();
+			running_ = false;
+		}
 		timer_.stop();
+		render_timer_.stop();
+		idle_timer_.stop();
+
+		// Draw the last frame
+		render();
 	}
 
 	void MaestroController::update() {
-		maestro_->update(get_total_elapsed_time(), false);
+		uint64_t time = get_total_elapsed_time();
+		{
+			TraceRecorder::Span span("MaestroController::update");
+			PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::Update);
+			section_updater_.update(*maestro_, time, false);
+		}
+		frame_sequence_++;
+		frame_pending_ = true;
+		PerformanceMonitor::increment(PerformanceMonitor::Counter::FramesSimulated);
+
+		// Count the ticks skipped since the last update, e.g. while the UI thread was busy
+		uint16_t interval = get_update_interval();
+		if (last_update_time_ > 0 && time - last_update_time_ >= 2u * interval) {
+			PerformanceMonitor::increment(PerformanceMonitor::Counter::MissedTicks, (time - last_update_time_) / interval - 1);
+		}
+		last_update_time_ = time;
+
+		/*
+		 * If the output won't change for at least another update, stop updating until it does.
+		 * Running a Cue wakes the Maestro early.
+		 * The idle timer follows the wall clock, so it's only armed when the Maestro does too. Otherwise, advance() and set_time_source() wake the Maestro.
+		 */
+		uint64_t until_change = IdleScheduler::get_time_until_change(*maestro_, time);
+		if (until_change > interval) {
+			idle_ = true;
+			last_update_time_ = 0;
+			timer_.stop();
+			if (until_change != IdleScheduler::NEVER && get_real_time()) {
+				idle_timer_.start(static_cast<int>(qMin<uint64_t>(until_change, INT_MAX)));
+			}
+		}
+	}
+
+	/**
+	 * Stops redrawing while every DrawingArea is hidden, and switches the Maestro to the hidden refresh interval.
+	 * The Maestro keeps running so that Shows and connected devices stay in sync.
+	 */
+	void MaestroController::update_visibility() {
+		bool hidden = true;
+		for (MaestroDrawingArea* drawing_area : drawing_areas_) {
+			if (drawing_area->get_exposed()) {
+				hidden = false;
+				break;
+			}
+		}
+
+		if (hidden == hidden_) return;
+		hidden_ = hidden;
+
+		if (simulation_thread_ != nullptr) {
+			simulation_thread_->wake();
+		}
+		else if (timer_.isActive()) {
+			timer_.start(get_update_interval());
+		}
+
+		if (hidden_) {
+			render_timer_.stop();
+		}
+		else {
+			resume();
+		}
 	}
 
 	/**
@@ -352,22 +572,18 @@ namespace PixelMaestroStudio {
 	 * @param cue Cue to append.
 	 */
 	void MaestroController::write_cue_to_stream(QDataStream& stream, uint8_t* cue) {
-		if (cue != nullptr) {
-			uint32_t size = maestro_->get_cue_controller().get_cue_size(cue);
-			stream.writeRawData((const char*)cue, (int)size);
-		}
+		CuefileEncoder::write_cue(stream, maestro_->get_cue_controller(), cue);
 	}
 
 	MaestroController::~MaestroController() {
 		// If automatic session saving is enabled, save Maestro configuration
 		QSettings settings;
 		if (settings.value(PreferencesDialog::save_session).toBool()) {
-			QByteArray maestro_config;
-			QDataStream maestro_datastream(&maestro_config, QIODevice::Truncate);
-			save_maestro_to_datastream(maestro_datastream);
-			settings.setValue(PreferencesDialog::last_session, maestro_config);
+			settings.setValue(PreferencesDialog::last_session, cuefile_cache_.get_cuefile());
 		}
 
+		delete simulation_thread_;
+		cuefile_cache_.wait();
 
 		delete [] sections_;
 	}
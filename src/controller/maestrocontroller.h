@@ -7,15 +7,22 @@
 
 #include "core/maestro.h"
 #include "core/section.h"
+#include "controller/cuefilecache.h"
+#include "controller/maestroframe.h"
+#include "controller/sectionupdater.h"
+#include "controller/simulationthreadcontroller.h"
+#include "controller/timesource.h"
 #include "drawingarea/maestrodrawingarea.h"
 #include "widget/maestrocontrolwidget.h"
+#include <QByteArray>
 #include <QDataStream>
-#include <QElapsedTimer>
+#include <QMutex>
 #include <QObject>
 #include <QSharedPointer>
 #include <QString>
 #include <QTimer>
 #include <QVector>
+#include <atomic>
 
 using namespace PixelMaestro;
 
@@ -28,31 +35,72 @@ namespace PixelMaestroStudio {
 			MaestroController(MaestroControlWidget& maestro_control_widget);
 			~MaestroController();
 			void add_drawing_area(MaestroDrawingArea& drawing_area);
+			uint32_t advance(uint64_t duration, uint16_t step = 0);
+			CuefileCache& get_cuefile_cache();
+			const MaestroFrame* get_frame();
 			Maestro& get_maestro();
+			QMutex* get_maestro_mutex();
+			bool get_real_time() const;
 			bool get_running();
+			SectionUpdater& get_section_updater();
+			TimeSource& get_time_source();
 			uint64_t get_total_elapsed_time();
+			uint16_t get_update_interval() const;
 			void initialize_maestro();
 			void remove_drawing_area(MaestroDrawingArea& drawing_area);
+			void run_cue(uint8_t* cue);
+			uint32_t run_cuefile(const QByteArray& cuefile, bool show_cues_only = false);
 			void save_maestro_to_datastream(QDataStream& datastream, QVector<CueController::Handler>* save_handlers = nullptr);
 			void save_section_to_datastream(QDataStream& datastream, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers = nullptr);
 			void write_cue_to_stream(QDataStream& stream, uint8_t* cue);
 			Section* set_sections(uint8_t num_sections, Point dimensions = Point(10, 10));
+			void set_time_source(TimeSource* time_source);
 			void start();
 			void stop();
 
 		private:
+			/// The Maestro's Cuefile, encoded one Layer at a time.
+			CuefileCache cuefile_cache_;
+
 			/// References each drawing area that the Maestro is rendering to.
 			QVector<MaestroDrawingArea*> drawing_areas_;
 
-			/// Tracks the time that the Maestro was last paused.
-			uint64_t last_pause_ = 0;
+			/// Snapshot of the Maestro's output shared by every DrawingArea. Only used when the Maestro is updated on the UI thread.
+			MaestroFrame frame_;
+
+			/// Whether the Maestro produced a frame that hasn't been drawn yet.
+			bool frame_pending_ = false;
+
+			/// Incremented each time the Maestro's output might have changed. The frame is recaptured when it falls behind.
+			uint32_t frame_sequence_ = 1;
+
+			/// Whether every DrawingArea is hidden. Set from the UI thread, read by the simulation thread.
+			std::atomic<bool> hidden_{false};
+
+			/// The Maestro's refresh interval while every DrawingArea is hidden. 0 keeps the normal interval.
+			uint16_t hidden_interval_ = 0;
+
+			/// Whether updates are suspended because the Maestro's output isn't changing.
+			bool idle_ = false;
+
+			/// Wakes the Maestro at the end of an idle period.
+			QTimer idle_timer_;
 
-			/// Updates the Maestro's runtime.
-			QElapsedTimer elapsed_timer_;
+			/// The Maestro time of the last update. 0 if the next update shouldn't be checked for missed ticks.
+			uint64_t last_update_time_ = 0;
+
+			/// Provides the Maestro's runtime.
+			QSharedPointer<TimeSource> time_source_ = QSharedPointer<TimeSource>(new RealTimeSource());
 
 			/// Maestro refresh timer.
 			QTimer timer_;
 
+			/// Preview refresh timer. Redraws the drawing areas independently of the Maestro's refresh rate.
+			QTimer render_timer_;
+
+			/// The time between preview redraws in milliseconds.
+			int render_interval_ = 16;
+
 			/// Maestro controlled by this controller.
 			QSharedPointer<Maestro> maestro_;
 
@@ -62,11 +110,26 @@ namespace PixelMaestroStudio {
 			/// The number of Sections in the Maestro.
 			uint8_t num_sections_ = 0;
 
+			/// Whether the Maestro is running.
+			bool running_ = false;
+
 			/// Sections belonging to the Maestro.
 			Section* sections_ = nullptr;
 
+			/// Runs each Maestro update, either serially or across a thread pool.
+			SectionUpdater section_updater_;
+
+			/// Thread that updates the Maestro. If null, the Maestro is updated on the UI thread.
+			SimulationThreadController* simulation_thread_ = nullptr;
+
+			uint16_t get_default_interval();
+			int get_render_interval();
+
 		private slots:
+			void render();
+			void resume();
 			void update();
+			void update_visibility();
 	};
 }
 
@@ -0,0 +1,66 @@
+#include "core/section.h"
+#include "maestroframe.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Copies the current color of each Pixel in the Maestro.
+	 * Memory is only reallocated if the total number of Pixels changed.
+	 * @param maestro Maestro to capture.
+	 * @param sequence Frame sequence number.
+	 */
+	void MaestroFrame::capture(Maestro& maestro, uint32_t sequence) {
+		sequence_ = sequence;
+
+		uint8_t num_sections = maestro.get_num_sections();
+		sections_.resize(num_sections);
+
+		uint32_t num_pixels = 0;
+		for (uint8_t section = 0; section < num_sections; section++) {
+			Point& dimensions = maestro.get_section(section)->get_dimensions();
+			sections_[section].offset = num_pixels;
+			sections_[section].width = dimensions.x;
+			sections_[section].height = dimensions.y;
+			num_pixels += dimensions.size();
+		}
+		pixels_.resize(num_pixels);
+
+		for (uint8_t section = 0; section < num_sections; section++) {
+			compositor_.composite(*maestro.get_section(section), pixels_.data() + sections_[section].offset);
+		}
+	}
+
+	/**
+	 * Returns the size of a Section at the time of capture.
+	 * @param section Section index.
+	 * @return Section dimensions.
+	 */
+	Point MaestroFrame::get_dimensions(uint8_t section) const {
+		return Point(sections_[section].width, sections_[section].height);
+	}
+
+	/**
+	 * Returns the number of Sections in the frame.
+	 * @return Number of Sections.
+	 */
+	uint8_t MaestroFrame::get_num_sections() const {
+		return static_cast<uint8_t>(sections_.size());
+	}
+
+	/**
+	 * Returns the colors of a Section's Pixels, stored row by row.
+	 * @param section Section index.
+	 * @return Pixel colors.
+	 */
+	const QRgb* MaestroFrame::get_pixels(uint8_t section) const {
+		return pixels_.constData() + sections_[section].offset;
+	}
+
+	/**
+	 * Returns the frame's sequence number.
+	 * Frames with the same sequence number have identical contents.
+	 * @return Sequence number.
+	 */
+	uint32_t MaestroFrame::get_sequence() const {
+		return sequence_;
+	}
+}
@@ -0,0 +1,52 @@
+/*
+ * MaestroFrame - Snapshot of every Section's output at a single point in time.
+ */
+
+#ifndef MAESTROFRAME_H
+#define MAESTROFRAME_H
+
+#include <QColor>
+#include <QVector>
+#include "core/maestro.h"
+#include "core/point.h"
+#include "sectioncompositor.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class MaestroFrame {
+		public:
+			void capture(Maestro& maestro, uint32_t sequence);
+			Point get_dimensions(uint8_t section) const;
+			uint8_t get_num_sections() const;
+			const QRgb* get_pixels(uint8_t section) const;
+			uint32_t get_sequence() const;
+
+		private:
+			/// Location and size of a Section within the frame.
+			struct SectionFrame {
+				/// Index of the Section's first Pixel.
+				uint32_t offset = 0;
+
+				/// Section width.
+				uint16_t width = 0;
+
+				/// Section height.
+				uint16_t height = 0;
+			};
+
+			/// Renders each Section into pixels_.
+			SectionCompositor compositor_;
+
+			/// Color of each Pixel in each Section, stored row by row.
+			QVector<QRgb> pixels_;
+
+			/// The layout of each Section in pixels_.
+			QVector<SectionFrame> sections_;
+
+			/// Identifies the Maestro state that the frame was captured from. 0 if the frame hasn't been captured.
+			uint32_t sequence_ = 0;
+	};
+}
+
+#endif // MAESTROFRAME_H
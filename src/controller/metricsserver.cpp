@@ -0,0 +1,171 @@
+#include <QHostAddress>
+#include <QSettings>
+#include <QTcpSocket>
+#include "dialog/preferencesdialog.h"
+#include "metricsserver.h"
+#include "utility/performancemonitor.h"
+#include "widget/devicecontrolwidget.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * The server doesn't listen until apply_settings() is called.
+	 * @param parent Parent object.
+	 * @param device_control_widget Widget that owns the devices being reported on.
+	 */
+	MetricsServer::MetricsServer(QObject* parent, DeviceControlWidget& device_control_widget) : QObject(parent), device_control_widget_(device_control_widget), server_(this) {
+		connect(&server_, &QTcpServer::newConnection, this, &MetricsServer::accept_connection);
+	}
+
+	/**
+	 * Handles new connections.
+	 */
+	void MetricsServer::accept_connection() {
+		while (server_.hasPendingConnections()) {
+			QTcpSocket* socket = server_.nextPendingConnection();
+			connect(socket, &QTcpSocket::readyRead, this, &MetricsServer::read_request);
+			connect(socket, &QTcpSocket::disconnected, socket, &QTcpSocket::deleteLater);
+		}
+	}
+
+	/**
+	 * Starts, stops, or moves the server based on the user's settings.
+	 * @return False if the server should be listening but couldn't start.
+	 */
+	bool MetricsServer::apply_settings() {
+		QSettings settings;
+		bool enabled = settings.value(PreferencesDialog::metrics_enabled, false).toBool();
+		uint16_t port = static_cast<uint16_t>(settings.value(PreferencesDialog::metrics_port, DEFAULT_PORT).toUInt());
+
+		if (server_.isListening()) {
+			if (enabled && server_.serverPort() == port) return true;
+			server_.close();
+		}
+
+		if (!enabled) return true;
+
+		return server_.listen(QHostAddress::LocalHost, port);
+	}
+
+	/**
+	 * Escapes a string for use as a Prometheus label value.
+	 * @param value Label value.
+	 * @return Escaped label value.
+	 */
+	QString MetricsServer::escape_label(const QString& value) {
+		QString escaped = value;
+		escaped.replace("\\", "\\\\");
+		escaped.replace("\"", "\\\"");
+		escaped.replace("\n", "\\n");
+		return escaped;
+	}
+
+	/**
+	 * Returns the reason the server failed to start.
+	 * @return Error message.
+	 */
+	QString MetricsServer::get_error() const {
+		return server_.errorString();
+	}
+
+	/**
+	 * Returns whether the server is accepting connections.
+	 * @return True if listening.
+	 */
+	bool MetricsServer::get_listening() const {
+		return server_.isListening();
+	}
+
+	/**
+	 * Builds the metrics page.
+	 * @return Metrics in the Prometheus text format.
+	 */
+	QByteArray MetricsServer::get_metrics() const {
+		QByteArray out;
+
+		struct CounterMetric {
+			const char* name;
+			const char* help;
+			PerformanceMonitor::Counter counter;
+		};
+		const CounterMetric counters[] = {
+			{ "pixelmaestro_frames_simulated_total", "Maestro updates.", PerformanceMonitor::Counter::FramesSimulated },
+			{ "pixelmaestro_frames_presented_total", "Frames drawn to the screen.", PerformanceMonitor::Counter::FramesPresented },
+			{ "pixelmaestro_deadline_misses_total", "Refresh intervals skipped because an update ran late.", PerformanceMonitor::Counter::MissedTicks },
+			{ "pixelmaestro_cues_run_total", "Cues run on the Maestro.", PerformanceMonitor::Counter::CuesRun }
+		};
+		for (const CounterMetric& metric : counters) {
+			out += QString("# HELP %1 %2\n# TYPE %1 counter\n%1 %3\n")
+				.arg(metric.name)
+				.arg(metric.help)
+				.arg(PerformanceMonitor::get_count(metric.counter)).toUtf8();
+		}
+
+		out += QString("# HELP pixelmaestro_cuefile_size_bytes Size of the most recently generated Cuefile.\n# TYPE pixelmaestro_cuefile_size_bytes gauge\npixelmaestro_cuefile_size_bytes %1\n")
+			.arg(PerformanceMonitor::get_value(PerformanceMonitor::Gauge::CuefileSize)).toUtf8();
+
+		const QVector<DeviceController>& devices = device_control_widget_.get_devices();
+
+		out += "# HELP pixelmaestro_device_bytes_written_total Bytes written to each device.\n# TYPE pixelmaestro_device_bytes_written_total counter\n";
+		for (const DeviceController& device : devices) {
+			out += QString("pixelmaestro_device_bytes_written_total{device=\"%1\"} %2\n")
+				.arg(escape_label(device.get_port_name()))
+				.arg(device.get_statistics().bytes_written.load(std::memory_order_relaxed)).toUtf8();
+		}
+
+		out += "# HELP pixelmaestro_device_write_queue_depth Writes to each device that haven't finished.\n# TYPE pixelmaestro_device_write_queue_depth gauge\n";
+		for (const DeviceController& device : devices) {
+			out += QString("pixelmaestro_device_write_queue_depth{device=\"%1\"} %2\n")
+				.arg(escape_label(device.get_port_name()))
+				.arg(device.get_statistics().pending_writes.load(std::memory_order_relaxed)).toUtf8();
+		}
+
+		return out;
+	}
+
+	/**
+	 * Answers a request once its headers have arrived.
+	 * Only GET /metrics is served. The connection is closed after each response.
+	 */
+	void MetricsServer::read_request() {
+		QTcpSocket* socket = qobject_cast<QTcpSocket*>(sender());
+		if (socket == nullptr) return;
+
+		// Wait for the end of the headers without consuming them
+		QByteArray request = socket->peek(MAX_REQUEST_SIZE);
+		if (!request.contains("\r\n\r\n") && !request.contains("\n\n")) {
+			if (request.size() >= MAX_REQUEST_SIZE) {
+				socket->abort();
+			}
+			return;
+		}
+		socket->readAll();
+
+		QList<QByteArray> request_line = request.left(request.indexOf('\n')).trimmed().split(' ');
+		QByteArray status;
+		QByteArray content_type = "text/plain; charset=utf-8";
+		QByteArray body;
+		if (request_line.size() < 2 || (request_line[0] != "GET" && request_line[0] != "HEAD")) {
+			status = "405 Method Not Allowed";
+		}
+		else if (request_line[1] == "/metrics" || request_line[1].startsWith("/metrics?")) {
+			status = "200 OK";
+			content_type = "text/plain; version=0.0.4; charset=utf-8";
+			body = get_metrics();
+		}
+		else {
+			status = "404 Not Found";
+		}
+
+		QByteArray response = "HTTP/1.1 " + status + "\r\n" +
+			"Content-Type: " + content_type + "\r\n" +
+			"Content-Length: " + QByteArray::number(body.size()) + "\r\n" +
+			"Connection: close\r\n\r\n";
+		if (request_line.size() < 1 || request_line[0] != "HEAD") {
+			response += body;
+		}
+
+		socket->write(response);
+		socket->disconnectFromHost();
+	}
+}
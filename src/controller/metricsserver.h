@@ -0,0 +1,50 @@
+/*
+ * MetricsServer - Serves render and device counters over HTTP in the Prometheus text format.
+ * The server only listens on the loopback interface. Requests are answered from lock-free counters, so scraping never waits on the render loop.
+ */
+
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QByteArray>
+#include <QObject>
+#include <QString>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+namespace PixelMaestroStudio {
+	class DeviceControlWidget;
+
+	class MetricsServer : public QObject {
+		Q_OBJECT
+
+		public:
+			/// Default port to listen on.
+			static const uint16_t DEFAULT_PORT = 9877;
+
+			/// The largest request accepted before the connection is dropped.
+			static const int MAX_REQUEST_SIZE = 8192;
+
+			MetricsServer(QObject* parent, DeviceControlWidget& device_control_widget);
+			bool apply_settings();
+			QString get_error() const;
+			bool get_listening() const;
+			QByteArray get_metrics() const;
+
+		private slots:
+			void accept_connection();
+			void read_request();
+
+		private:
+			/// Widget that owns the device list.
+			DeviceControlWidget& device_control_widget_;
+
+			/// Listens for scrapes.
+			QTcpServer server_;
+
+			static QString escape_label(const QString& value);
+	};
+}
+
+#endif // METRICSSERVER_H
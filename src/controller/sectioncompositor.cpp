@@ -0,0 +1,246 @@
+#include "sectioncompositor.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Writes the final color of every Pixel in a Section to a buffer, row by row.
+	 * Produces the same colors as calling Section::get_pixel_color() on each Pixel.
+	 * @param section Section to composite.
+	 * @param output Buffer with room for every Pixel in the Section.
+	 */
+	void SectionCompositor::composite(Section& section, QRgb* output) {
+		const Point& dimensions = section.get_dimensions();
+
+		layers_.clear();
+		layers_.push_back({ &section, Colors::MixMode::None, 0 });
+		for (Section::Layer* layer = section.get_layer(); layer != nullptr && layer->section != nullptr; layer = layer->section->get_layer()) {
+			layers_.push_back({ layer->section, layer->mix_mode, layer->alpha });
+		}
+
+		/*
+		 * Canvases and brightness change colors, so Layers using them are left to get_pixel_color().
+		 * get_pixel_color() on a Layer already includes every Layer above it, so it's only needed from the lowest such Layer up.
+		 * Everything beneath that Layer is still mixed here.
+		 */
+		size_t top = layers_.size() - 1;
+		bool direct = true;
+		for (size_t layer = 0; layer < layers_.size(); layer++) {
+			if (!get_direct(*layers_[layer].section, dimensions)) {
+				top = layer;
+				direct = false;
+				break;
+			}
+		}
+
+		for (MixTable& table : mix_tables_) {
+			table.used = false;
+		}
+
+		remaps_.resize(layers_.size());
+		row_.resize(dimensions.x);
+		layer_row_.resize(dimensions.x);
+		Colors::RGB* row = row_.data();
+
+		// Each Layer is mixed with the result of every Layer above it, so start from the top and work down
+		for (uint16_t y = 0; y < dimensions.y; y++) {
+			if (direct) {
+				read_row(*layers_[top].section, y, get_remap(top), row);
+			}
+			else {
+				Section* top_section = layers_[top].section;
+				for (uint16_t x = 0; x < dimensions.x; x++) {
+					row[x] = top_section->get_pixel_color(x, y);
+				}
+			}
+
+			for (size_t layer = top; layer > 0; layer--) {
+				read_row(*layers_[layer - 1].section, y, get_remap(layer - 1), layer_row_.data());
+				mix_row(layers_[layer].mix_mode, layers_[layer].alpha, dimensions.x);
+			}
+
+			for (uint16_t x = 0; x < dimensions.x; x++) {
+				*output++ = qRgb(row[x].r, row[x].g, row[x].b);
+			}
+		}
+
+		for (size_t table = mix_tables_.size(); table > 0; table--) {
+			if (!mix_tables_[table - 1].used) {
+				mix_tables_.erase(mix_tables_.begin() + static_cast<long>(table - 1));
+			}
+		}
+	}
+
+	/**
+	 * Returns whether a Section's Pixel colors can be used as-is.
+	 * @param section Section to check.
+	 * @param dimensions Size of the Section being composited.
+	 * @return True if nothing changes the Section's colors after its Animation draws them.
+	 */
+	bool SectionCompositor::get_direct(Section& section, const Point& dimensions) {
+		return section.get_canvas() == nullptr &&
+			section.get_brightness() == 255 &&
+			section.get_dimensions().x == dimensions.x &&
+			section.get_dimensions().y == dimensions.y;
+	}
+
+	/**
+	 * Returns the mix table for a mix mode and alpha, building it if needed.
+	 * The table is filled in from Colors::mix_colors(), so mixing through it gives exactly the same results.
+	 * @param mix_mode Mix mode.
+	 * @param alpha Alpha.
+	 * @return Mixed channel values, indexed by (below << 8) | above.
+	 */
+	const uint8_t* SectionCompositor::get_mix_table(Colors::MixMode mix_mode, uint8_t alpha) {
+		for (MixTable& table : mix_tables_) {
+			if (table.mix_mode == mix_mode && table.alpha == alpha) {
+				table.used = true;
+				return table.values.data();
+			}
+		}
+
+		mix_tables_.push_back({ mix_mode, alpha, true, std::vector<uint8_t>(256 * 256) });
+		uint8_t* values = mix_tables_.back().values.data();
+		for (uint16_t below = 0; below < 256; below++) {
+			for (uint16_t above = 0; above < 256; above++) {
+				Colors::RGB mixed = Colors::mix_colors(Colors::RGB(below, below, below), Colors::RGB(above, above, above), mix_mode, alpha);
+				values[(below << 8) | above] = mixed.r;
+			}
+		}
+		return values;
+	}
+
+	/**
+	 * Returns the remap table for a Layer, rebuilding it if the Layer's dimensions, offset, mirroring, or wrapping changed.
+	 * Scrolling works by changing the offset, so a scrolling Layer's table is rebuilt each time it moves.
+	 * Follows the same steps as Section::get_pixel_color(): mirrored Pixels in the far half display the matching Pixel in the near half, then the offset is added, wrapping around the Layer or going black past its edge.
+	 * @param layer Index of the Layer in the chain.
+	 * @return Source Pixel indices, or nullptr if every Pixel displays itself.
+	 */
+	const int32_t* SectionCompositor::get_remap(size_t layer) {
+		Section& section = *layers_[layer].section;
+		const Point& dimensions = section.get_dimensions();
+		const Point& offset = section.get_offset();
+		Section::Mirror* mirror = section.get_mirror();
+		const bool mirror_x = (mirror != nullptr && mirror->x);
+		const bool mirror_y = (mirror != nullptr && mirror->y);
+		const bool wrap = section.get_wrap();
+
+		Remap& remap = remaps_[layer];
+		if (remap.width == dimensions.x && remap.height == dimensions.y &&
+			remap.offset_x == offset.x && remap.offset_y == offset.y &&
+			remap.mirror_x == mirror_x && remap.mirror_y == mirror_y && remap.wrap == wrap) {
+			return remap.identity ? nullptr : remap.indices.data();
+		}
+
+		remap.width = dimensions.x;
+		remap.height = dimensions.y;
+		remap.offset_x = offset.x;
+		remap.offset_y = offset.y;
+		remap.mirror_x = mirror_x;
+		remap.mirror_y = mirror_y;
+		remap.wrap = wrap;
+		remap.identity = (offset.x == 0 && offset.y == 0 && !mirror_x && !mirror_y);
+
+		if (remap.identity) {
+			remap.indices.clear();
+			return nullptr;
+		}
+
+		remap.indices.resize(dimensions.size());
+		int32_t* indices = remap.indices.data();
+		for (uint16_t y = 0; y < dimensions.y; y++) {
+			for (uint16_t x = 0; x < dimensions.x; x++) {
+				uint32_t source_x = x;
+				uint32_t source_y = y;
+
+				// Mirroring across the x axis flips rows, and mirroring across the y axis flips columns
+				if (mirror_x && source_y >= dimensions.y / 2u) {
+					source_y = dimensions.y - 1u - source_y;
+				}
+				if (mirror_y && source_x >= dimensions.x / 2u) {
+					source_x = dimensions.x - 1u - source_x;
+				}
+
+				source_x += offset.x;
+				source_y += offset.y;
+				if (wrap) {
+					source_x %= dimensions.x;
+					source_y %= dimensions.y;
+				}
+
+				if (source_x < dimensions.x && source_y < dimensions.y) {
+					*indices++ = static_cast<int32_t>((source_y * dimensions.x) + source_x);
+				}
+				else {
+					*indices++ = -1;
+				}
+			}
+		}
+
+		return remap.indices.data();
+	}
+
+	/**
+	 * Mixes the current Layer row into the colors mixed so far.
+	 * @param mix_mode How the colors mixed so far are mixed with the Layer beneath them.
+	 * @param alpha Amount used when mixing.
+	 * @param width Number of Pixels in the row.
+	 */
+	void SectionCompositor::mix_row(Colors::MixMode mix_mode, uint8_t alpha, uint16_t width) {
+		Colors::RGB* row = row_.data();
+		const Colors::RGB* below = layer_row_.data();
+
+		switch (mix_mode) {
+			case Colors::MixMode::Alpha:
+			case Colors::MixMode::Multiply:
+				{
+					const uint8_t* table = get_mix_table(mix_mode, alpha);
+					for (uint16_t x = 0; x < width; x++) {
+						row[x].r = table[(below[x].r << 8) | row[x].r];
+						row[x].g = table[(below[x].g << 8) | row[x].g];
+						row[x].b = table[(below[x].b << 8) | row[x].b];
+					}
+				}
+				break;
+			case Colors::MixMode::Overlay:
+				// Black Pixels let the Layer beneath show through
+				for (uint16_t x = 0; x < width; x++) {
+					if (row[x].r == 0 && row[x].g == 0 && row[x].b == 0) {
+						row[x] = below[x];
+					}
+				}
+				break;
+			default:
+				// Layers that don't mix are hidden
+				for (uint16_t x = 0; x < width; x++) {
+					row[x] = below[x];
+				}
+				break;
+		}
+	}
+
+	/**
+	 * Copies the colors displayed by a row of Pixels.
+	 * @param section Section to read.
+	 * @param y Row to read.
+	 * @param remap Remap table for the Section, or nullptr if every Pixel displays itself.
+	 * @param row Buffer with room for the row.
+	 */
+	void SectionCompositor::read_row(Section& section, uint16_t y, const int32_t* remap, Colors::RGB* row) {
+		const uint16_t width = section.get_dimensions().x;
+
+		// Pixels are stored row by row, so the row is contiguous
+		if (remap == nullptr) {
+			Pixel* pixels = &section.get_pixel(0, y);
+			for (uint16_t x = 0; x < width; x++) {
+				row[x] = pixels[x].get_color();
+			}
+			return;
+		}
+
+		Pixel* pixels = &section.get_pixel(0, 0);
+		remap += y * width;
+		for (uint16_t x = 0; x < width; x++) {
+			row[x] = (remap[x] < 0) ? Colors::RGB(0, 0, 0) : pixels[remap[x]].get_color();
+		}
+	}
+}
@@ -0,0 +1,103 @@
+/*
+ * SectionCompositor - Renders a Section and all of its Layers into a buffer in one pass.
+ * Section::get_pixel_color() walks the Layer chain separately for every Pixel. The compositor walks the chain once per row instead, copying each Layer's row into a contiguous buffer and mixing it with the rows above it in a tight loop.
+ * Offsets, scrolling, mirroring, and wrapping are handled with a per-Layer table of source Pixels that's only rebuilt when one of them changes.
+ */
+
+#ifndef SECTIONCOMPOSITOR_H
+#define SECTIONCOMPOSITOR_H
+
+#include <QColor>
+#include <vector>
+#include "core/colors.h"
+#include "core/section.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class SectionCompositor {
+		public:
+			void composite(Section& section, QRgb* output);
+
+		private:
+			/// A Layer in the chain being composited.
+			struct LayerStep {
+				/// The Layer's Section.
+				Section* section;
+
+				/// How the Layer mixes with the Section beneath it.
+				Colors::MixMode mix_mode;
+
+				/// Amount used when mixing.
+				uint8_t alpha;
+			};
+
+			/// Results of Colors::mix_colors() for every pair of channel values, indexed by (below << 8) | above.
+			struct MixTable {
+				/// Mix mode the table was built for.
+				Colors::MixMode mix_mode;
+
+				/// Alpha the table was built for.
+				uint8_t alpha;
+
+				/// Whether the table was used during the last call to composite().
+				bool used;
+
+				/// Mixed channel values.
+				std::vector<uint8_t> values;
+			};
+
+			/// Maps each Pixel in a Layer to the Pixel it displays.
+			struct Remap {
+				/// Layer width the table was built for.
+				uint16_t width = 0;
+
+				/// Layer height the table was built for.
+				uint16_t height = 0;
+
+				/// Horizontal offset the table was built for.
+				uint16_t offset_x = 0;
+
+				/// Vertical offset the table was built for.
+				uint16_t offset_y = 0;
+
+				/// Whether the Layer was mirrored across the x axis.
+				bool mirror_x = false;
+
+				/// Whether the Layer was mirrored across the y axis.
+				bool mirror_y = false;
+
+				/// Whether the Layer wrapped.
+				bool wrap = false;
+
+				/// Whether every Pixel displays itself, in which case the table is empty.
+				bool identity = true;
+
+				/// Index of the Pixel each Pixel displays, stored row by row. -1 means the Pixel is black.
+				std::vector<int32_t> indices;
+			};
+
+			/// The Section's Layer chain, from the Section itself to its topmost Layer.
+			std::vector<LayerStep> layers_;
+
+			/// Colors of the current row in the Layer being mixed in.
+			std::vector<Colors::RGB> layer_row_;
+
+			/// Mix tables built so far. Tables that go unused for a frame are dropped.
+			std::vector<MixTable> mix_tables_;
+
+			/// Remap tables for each Layer in the chain.
+			std::vector<Remap> remaps_;
+
+			/// Colors of the current row mixed so far.
+			std::vector<Colors::RGB> row_;
+
+			static bool get_direct(Section& section, const Point& dimensions);
+			const uint8_t* get_mix_table(Colors::MixMode mix_mode, uint8_t alpha);
+			const int32_t* get_remap(size_t layer);
+			void mix_row(Colors::MixMode mix_mode, uint8_t alpha, uint16_t width);
+			static void read_row(Section& section, uint16_t y, const int32_t* remap, Colors::RGB* row);
+	};
+}
+
+#endif // SECTIONCOMPOSITOR_H
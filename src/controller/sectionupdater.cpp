@@ -0,0 +1,108 @@
+#include <QtConcurrent/QtConcurrentMap>
+#include <algorithm>
+#include <functional>
+#include "cue/show.h"
+#include "idlescheduler.h"
+#include "sectionupdater.h"
+#include "utility/performancemonitor.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Returns whether Sections are updated in parallel.
+	 * @return True if parallel.
+	 */
+	bool SectionUpdater::get_parallel() const {
+		return parallel_;
+	}
+
+	/**
+	 * Marks every Section as due on the next update.
+	 * Call this whenever something other than an update changes the Maestro, such as running a Cue. Safe to call from any thread.
+	 */
+	void SectionUpdater::invalidate() {
+		stale_.store(true, std::memory_order_release);
+	}
+
+	/**
+	 * Schedules every Section for the next update.
+	 * @param maestro Maestro being updated.
+	 */
+	void SectionUpdater::rebuild(Maestro& maestro) {
+		maestro_ = &maestro;
+		deadlines_.clear();
+		for (uint8_t section = 0; section < maestro.get_num_sections(); section++) {
+			deadlines_.push_back({ 0, maestro.get_section(section) });
+		}
+		std::make_heap(deadlines_.begin(), deadlines_.end(), std::greater<Deadline>());
+	}
+
+	/**
+	 * Sets whether Sections are updated in parallel.
+	 * @param parallel If true, update Sections in parallel.
+	 */
+	void SectionUpdater::set_parallel(bool parallel) {
+		this->parallel_ = parallel;
+	}
+
+	/**
+	 * Updates the Maestro if its refresh interval has elapsed.
+	 * Only Sections whose next change is due are updated. Each one is then rescheduled using IdleScheduler.
+	 * In parallel mode, due Sections are handed out to the global thread pool one at a time, so idle threads pick up the remaining Sections while others are busy with larger ones. The calling thread takes part and returns once every Section is done.
+	 * @param maestro Maestro to update.
+	 * @param current_time Current Maestro time.
+	 * @param force If true, update even if the refresh interval hasn't elapsed.
+	 * @return True if the Maestro was updated.
+	 */
+	bool SectionUpdater::update(Maestro& maestro, uint64_t current_time, bool force) {
+		if (!force && !maestro.get_timer().update(current_time)) {
+			return false;
+		}
+
+		// Show Events can change Sections, so they run before any Section updates
+		Show* show = maestro.get_show();
+		if (show != nullptr) {
+			uint16_t index = show->get_current_index();
+			show->update(current_time);
+
+			// An Event ran, so any Section could have changed. The index wraps around when a looping Show starts over.
+			uint16_t new_index = show->get_current_index();
+			if (new_index != index) {
+				PerformanceMonitor::increment(PerformanceMonitor::Counter::CuesRun, (new_index > index) ? new_index - index : show->get_num_events() - index + new_index);
+				invalidate();
+			}
+		}
+
+		if (stale_.exchange(false, std::memory_order_acquire) || maestro_ != &maestro) {
+			rebuild(maestro);
+		}
+
+		sections_.clear();
+		while (!deadlines_.empty() && deadlines_.front().time <= current_time) {
+			std::pop_heap(deadlines_.begin(), deadlines_.end(), std::greater<Deadline>());
+			sections_.push_back(deadlines_.back().section);
+			deadlines_.pop_back();
+		}
+
+		// Each Section only touches itself and its own Layers
+		if (parallel_ && sections_.size() > 1) {
+			QtConcurrent::blockingMap(sections_.begin(), sections_.end(), [current_time](Section* section) {
+				section->update(current_time);
+			});
+		}
+		else {
+			for (Section* section : sections_) {
+				section->update(current_time);
+			}
+		}
+
+		for (Section* section : sections_) {
+			uint64_t until_change = IdleScheduler::get_time_until_change(*section, current_time);
+			if (until_change != IdleScheduler::NEVER) {
+				deadlines_.push_back({ current_time + until_change, section });
+				std::push_heap(deadlines_.begin(), deadlines_.end(), std::greater<Deadline>());
+			}
+		}
+
+		return true;
+	}
+}
@@ -0,0 +1,64 @@
+/*
+ * SectionUpdater - Updates a Maestro, optionally spreading its Sections across every CPU core.
+ * Follows the same steps as Maestro::update(): the Show runs first on the calling thread, then the Sections are updated. Cues are never run during an update, so they and Show Events apply in the same order either way.
+ * Sections are kept in a min-heap ordered by when they can next change, which is the next tick of their Animation, scroll, or Canvas timer (see IdleScheduler). Each update only touches the Sections that are due, so slow Animations and Canvases cost nothing between ticks, and idle Sections cost nothing at all.
+ */
+
+#ifndef SECTIONUPDATER_H
+#define SECTIONUPDATER_H
+
+#include <atomic>
+#include <stdint.h>
+#include <vector>
+#include "core/maestro.h"
+#include "core/section.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class SectionUpdater {
+		public:
+			bool get_parallel() const;
+			void invalidate();
+			void set_parallel(bool parallel);
+			bool update(Maestro& maestro, uint64_t current_time, bool force = false);
+
+		private:
+			/// When a Section next needs to be updated.
+			struct Deadline {
+				/// Maestro time when the Section can next change.
+				uint64_t time;
+
+				/// Section to update.
+				Section* section;
+
+				/**
+				 * Orders Deadlines so that the earliest one is at the top of the heap.
+				 * @param other Deadline to compare against.
+				 * @return True if this Deadline is later.
+				 */
+				bool operator>(const Deadline& other) const {
+					return time > other.time;
+				}
+			};
+
+			/// Min-heap of Section deadlines. Sections that won't change on their own aren't in the heap.
+			std::vector<Deadline> deadlines_;
+
+			/// The Maestro that deadlines_ was built for.
+			Maestro* maestro_ = nullptr;
+
+			/// Whether Sections are updated in parallel.
+			bool parallel_ = false;
+
+			/// Sections to update. Kept between updates to avoid reallocating.
+			std::vector<Section*> sections_;
+
+			/// Whether the deadlines need to be rebuilt. Set from other threads when a Cue runs.
+			std::atomic<bool> stale_{true};
+
+			void rebuild(Maestro& maestro);
+	};
+}
+
+#endif // SECTIONUPDATER_H
@@ -0,0 +1,214 @@
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include "controller/idlescheduler.h"
+#include "controller/maestrocontroller.h"
+#include "utility/performancemonitor.h"
+#include "utility/tracerecorder.h"
+#include "simulationthreadcontroller.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * @param maestro_controller The controller managing the Maestro to update.
+	 */
+	SimulationThreadController::SimulationThreadController(MaestroController& maestro_controller) : QThread(nullptr), maestro_controller_(maestro_controller) { }
+
+	/**
+	 * Returns the frames published by the thread.
+	 * Only the UI thread may consume frames.
+	 * @return Published frames.
+	 */
+	TripleBuffer<MaestroFrame>& SimulationThreadController::get_frames() {
+		return frames_;
+	}
+
+	/**
+	 * Returns whether the thread has stopped updating the Maestro until its output changes.
+	 * @return True if idle.
+	 */
+	bool SimulationThreadController::get_idle() const {
+		return idle_;
+	}
+
+	/**
+	 * Returns the mutex guarding the Maestro.
+	 * Lock this before reading the Maestro's configuration from another thread.
+	 * @return Maestro mutex.
+	 */
+	QMutex* SimulationThreadController::get_mutex() {
+		return &mutex_;
+	}
+
+	/**
+	 * Sends a Cue to the thread and waits for it to run.
+	 * If the thread isn't running, the Cue runs immediately.
+	 * @param cue Cue to run.
+	 * @param size Size of the Cue.
+	 */
+	void SimulationThreadController::queue_cue(uint8_t* cue, uint32_t size) {
+		QMutexLocker locker(&mutex_);
+
+		if (!active_) {
+			maestro_controller_.get_maestro().get_cue_controller().run(cue);
+			PerformanceMonitor::increment(PerformanceMonitor::Counter::CuesRun);
+			return;
+		}
+
+		// Copy the Cue, since the CueController's buffer gets overwritten by the next Cue
+		cues_.enqueue(QByteArray(reinterpret_cast<const char*>(cue), static_cast<int>(size)));
+		uint32_t ticket = ++cues_queued_;
+		wake_condition_.wakeAll();
+
+		// Block until the Cue runs so that the UI can read back the result
+		while (cues_run_ < ticket) {
+			cue_condition_.wait(&mutex_);
+		}
+	}
+
+	/**
+	 * Copies the Maestro's output into a new frame and hands it to the UI.
+	 * Must be called with the mutex held.
+	 */
+	void SimulationThreadController::publish_frame() {
+		frames_.get_back().capture(maestro_controller_.get_maestro(), ++sequence_);
+		frames_.publish();
+	}
+
+	void SimulationThreadController::run() {
+		/*
+		 * How this works:
+		 *
+		 * The thread owns the Maestro while it's running. On each pass it applies any Cues sent from the UI, updates the Maestro if the next tick is due, then copies the output into a frame.
+		 * Frames are handed to the UI through a triple buffer, so neither thread ever waits on the other to read or write Pixels.
+		 * Between ticks the thread sleeps on a wait condition, which wakes early if a Cue arrives.
+		 * If nothing in the Maestro will change before the next tick, the thread sleeps until something does (see IdleScheduler).
+		 */
+
+		TraceRecorder::set_thread_name("Simulation");
+
+		QMutexLocker locker(&mutex_);
+		active_ = true;
+		idle_ = false;
+
+		QElapsedTimer clock;
+		clock.start();
+		qint64 next_tick = 0;
+		uint64_t last_update = 0;
+		bool changed = true;
+
+		while (!isInterruptionRequested()) {
+			Maestro& maestro = maestro_controller_.get_maestro();
+
+			// Run Cues sent from the UI
+			while (!cues_.isEmpty()) {
+				QByteArray cue = cues_.dequeue();
+				{
+					TraceRecorder::Span span("CueController::run");
+					maestro.get_cue_controller().run(reinterpret_cast<uint8_t*>(cue.data()));
+				}
+				cues_run_++;
+				PerformanceMonitor::increment(PerformanceMonitor::Counter::CuesRun);
+				changed = true;
+				maestro_controller_.get_section_updater().invalidate();
+
+				// A Cue can start an Animation, so update on this pass
+				idle_ = false;
+				next_tick = 0;
+				last_update = 0;
+			}
+			cue_condition_.wakeAll();
+
+			// Something outside of a Cue changed, such as the update interval
+			if (reschedule_) {
+				reschedule_ = false;
+				idle_ = false;
+				next_tick = 0;
+				last_update = 0;
+			}
+
+			bool running = maestro_controller_.get_running();
+			if (running && next_tick >= 0 && clock.elapsed() >= next_tick) {
+				uint64_t time = maestro_controller_.get_total_elapsed_time();
+				{
+					TraceRecorder::Span span("SimulationThreadController::update");
+					PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::Update);
+					maestro_controller_.get_section_updater().update(maestro, time, false);
+				}
+				PerformanceMonitor::increment(PerformanceMonitor::Counter::FramesSimulated);
+				changed = true;
+
+				// Let the UI know to start redrawing again
+				if (idle_.exchange(false)) {
+					emit resumed();
+				}
+
+				uint64_t interval = maestro_controller_.get_update_interval();
+				if (last_update > 0 && time - last_update >= 2 * interval) {
+					PerformanceMonitor::increment(PerformanceMonitor::Counter::MissedTicks, (time - last_update) / interval - 1);
+				}
+				last_update = time;
+
+				// The idle period is in Maestro time, so it can only be waited out on the wall clock in real time. Otherwise, sleep until woken.
+				uint64_t until_change = IdleScheduler::get_time_until_change(maestro, time);
+				if (until_change > interval) {
+					idle_ = true;
+					last_update = 0;
+					next_tick = (until_change == IdleScheduler::NEVER || !maestro_controller_.get_real_time()) ? -1 : clock.elapsed() + static_cast<qint64>(until_change);
+				}
+				else {
+					next_tick = clock.elapsed() + static_cast<qint64>(interval);
+				}
+			}
+
+			if (changed) {
+				publish_frame();
+				changed = false;
+			}
+
+			// Sleep until the next tick. If the Maestro is paused or won't change again, sleep until something wakes the thread.
+			if (running && next_tick >= 0) {
+				qint64 remaining = next_tick - clock.elapsed();
+				if (remaining > 0) {
+					wake_condition_.wait(&mutex_, static_cast<unsigned long>(remaining));
+				}
+			}
+			else {
+				wake_condition_.wait(&mutex_);
+
+				// Update as soon as the Maestro starts again
+				idle_ = false;
+				next_tick = 0;
+				last_update = 0;
+			}
+		}
+
+		// Release anyone still waiting on a Cue
+		active_ = false;
+		cues_.clear();
+		cues_run_ = cues_queued_;
+		cue_condition_.wakeAll();
+	}
+
+	/**
+	 * Stops the thread and waits for it to finish.
+	 */
+	void SimulationThreadController::stop() {
+		requestInterruption();
+		wake();
+		wait();
+	}
+
+	/**
+	 * Wakes the thread so that it picks up changes made outside of a Cue, such as starting the Maestro or changing its update interval.
+	 * The Maestro is updated as soon as the thread wakes.
+	 */
+	void SimulationThreadController::wake() {
+		QMutexLocker locker(&mutex_);
+		reschedule_ = true;
+		wake_condition_.wakeAll();
+	}
+
+	SimulationThreadController::~SimulationThreadController() {
+		stop();
+	}
+}
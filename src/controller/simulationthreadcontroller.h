@@ -0,0 +1,78 @@
+/*
+ * SimulationThreadController - Updates a Maestro on a separate thread and publishes each frame to the UI.
+ */
+
+#ifndef SIMULATIONTHREADCONTROLLER_H
+#define SIMULATIONTHREADCONTROLLER_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include "controller/maestroframe.h"
+#include "utility/triplebuffer.h"
+
+namespace PixelMaestroStudio {
+	class MaestroController;
+
+	class SimulationThreadController : public QThread {
+		Q_OBJECT
+
+		public:
+			explicit SimulationThreadController(MaestroController& maestro_controller);
+			~SimulationThreadController();
+			TripleBuffer<MaestroFrame>& get_frames();
+			bool get_idle() const;
+			QMutex* get_mutex();
+			void publish_frame();
+			void queue_cue(uint8_t* cue, uint32_t size);
+			void run() override;
+			void stop();
+			void wake();
+
+		signals:
+			/// Emitted when the thread resumes updating the Maestro after an idle period.
+			void resumed();
+
+		private:
+			/// Whether the thread is accepting Cues.
+			bool active_ = false;
+
+			/// Signals callers of queue_cue() that their Cues have run.
+			QWaitCondition cue_condition_;
+
+			/// Cues waiting to be run on the Maestro.
+			QQueue<QByteArray> cues_;
+
+			/// The number of Cues that have been queued.
+			uint32_t cues_queued_ = 0;
+
+			/// The number of Cues that have been run.
+			uint32_t cues_run_ = 0;
+
+			/// Whether the thread stopped updating the Maestro because its output isn't changing.
+			std::atomic<bool> idle_{false};
+
+			/// Frames handed off to the UI.
+			TripleBuffer<MaestroFrame> frames_;
+
+			/// The controller managing the Maestro.
+			MaestroController& maestro_controller_;
+
+			/// Guards the Maestro and the Cue queue.
+			QMutex mutex_;
+
+			/// Whether the thread should update the Maestro immediately instead of waiting for the next tick.
+			bool reschedule_ = false;
+
+			/// Sequence number of the last published frame.
+			uint32_t sequence_ = 0;
+
+			/// Wakes the thread when a Cue arrives or the thread needs to stop.
+			QWaitCondition wake_condition_;
+	};
+}
+
+#endif // SIMULATIONTHREADCONTROLLER_H
@@ -0,0 +1,84 @@
+#include "timesource.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Returns the time the clock has spent running.
+	 * @return Time in milliseconds.
+	 */
+	uint64_t RealTimeSource::get_time() const {
+		uint64_t time = last_pause_;
+
+		if (running_) {
+			time += elapsed_timer_.elapsed();
+		}
+
+		return time;
+	}
+
+	/**
+	 * Moves the clock to a new time. If the clock is running, it continues from there.
+	 * @param time New time in milliseconds.
+	 */
+	void RealTimeSource::set_time(uint64_t time) {
+		last_pause_ = time;
+		elapsed_timer_.restart();
+	}
+
+	/**
+	 * Starts or resumes the clock.
+	 */
+	void RealTimeSource::start() {
+		elapsed_timer_.restart();
+		running_ = true;
+	}
+
+	/**
+	 * Pauses the clock.
+	 */
+	void RealTimeSource::stop() {
+		if (running_) {
+			last_pause_ += elapsed_timer_.elapsed();
+		}
+		running_ = false;
+	}
+
+	/**
+	 * Constructor.
+	 * @param time Starting time in milliseconds.
+	 */
+	VirtualTimeSource::VirtualTimeSource(uint64_t time) : time_(time) { }
+
+	/**
+	 * Moves the clock forward.
+	 * @param amount Time to add in milliseconds.
+	 */
+	void VirtualTimeSource::advance(uint64_t amount) {
+		time_.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Returns the clock's time.
+	 * @return Time in milliseconds.
+	 */
+	uint64_t VirtualTimeSource::get_time() const {
+		return time_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Moves the clock to a new time.
+	 * @param time New time in milliseconds.
+	 */
+	void VirtualTimeSource::set_time(uint64_t time) {
+		time_.store(time, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Does nothing. A virtual clock only moves when it's advanced.
+	 */
+	void VirtualTimeSource::start() { }
+
+	/**
+	 * Does nothing. A virtual clock only moves when it's advanced.
+	 */
+	void VirtualTimeSource::stop() { }
+}
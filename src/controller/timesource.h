@@ -0,0 +1,70 @@
+/*
+ * TimeSource - Provides the Maestro's current time.
+ * RealTimeSource follows the wall clock. VirtualTimeSource only moves when told to, which makes it possible to simulate faster than real time and to repeat a run exactly.
+ */
+
+#ifndef TIMESOURCE_H
+#define TIMESOURCE_H
+
+#include <QElapsedTimer>
+#include <atomic>
+#include <stdint.h>
+
+namespace PixelMaestroStudio {
+	class TimeSource {
+		public:
+			virtual ~TimeSource() = default;
+
+			/**
+			 * Returns the current time.
+			 * @return Time in milliseconds since the source started.
+			 */
+			virtual uint64_t get_time() const = 0;
+
+			/**
+			 * Moves the clock to a new time.
+			 * @param time New time in milliseconds.
+			 */
+			virtual void set_time(uint64_t time) = 0;
+
+			/// Starts the clock.
+			virtual void start() = 0;
+
+			/// Stops the clock at its current time.
+			virtual void stop() = 0;
+	};
+
+	class RealTimeSource : public TimeSource {
+		public:
+			uint64_t get_time() const override;
+			void set_time(uint64_t time) override;
+			void start() override;
+			void stop() override;
+
+		private:
+			/// Measures the time since the clock last started.
+			QElapsedTimer elapsed_timer_;
+
+			/// The clock's time when it last stopped.
+			uint64_t last_pause_ = 0;
+
+			/// Whether the clock is running.
+			bool running_ = false;
+	};
+
+	class VirtualTimeSource : public TimeSource {
+		public:
+			explicit VirtualTimeSource(uint64_t time = 0);
+			void advance(uint64_t amount);
+			uint64_t get_time() const override;
+			void set_time(uint64_t time) override;
+			void start() override;
+			void stop() override;
+
+		private:
+			/// Current time. Read by the simulation thread.
+			std::atomic<uint64_t> time_;
+	};
+}
+
+#endif // TIMESOURCE_H
@@ -1,65 +1,12 @@
 #include <QSerialPortInfo>
 #include <QSettings>
 #include <QTime>
+#include "controller/metricsserver.h"
 #include "preferencesdialog.h"
 #include "ui_preferencesdialog.h"
 
 namespace PixelMaestroStudio {
 
-	QString PreferencesDialog::delimiter = QStringLiteral("|");
-	QString PreferencesDialog::sub_delimiter = QStringLiteral(",");
-
-	// "Files" section
-	QString PreferencesDialog::last_cuefile_directory = QStringLiteral("Files/LastCuefileDirectory");
-
-	// "Displays" section
-	QString PreferencesDialog::separate_window_option = QStringLiteral("Displays/SeparateWindow");
-	QString PreferencesDialog::main_window_option = QStringLiteral("Displays/MainWindow");
-
-	// "Maestro" section
-	QString PreferencesDialog::num_sections = QStringLiteral("Maestro/NumSections");
-	QString PreferencesDialog::num_sections_per_row = QStringLiteral("Maestro/NumSectionsPerRow");
-	QString PreferencesDialog::refresh_rate = QStringLiteral("Maestro/Refresh");
-
-	// "Interface" section
-	QString PreferencesDialog::pause_on_start = QStringLiteral("Interface/PauseOnStart");
-	QString PreferencesDialog::pixel_shape = QStringLiteral("Interface/Shape");
-	QString PreferencesDialog::save_session = QStringLiteral("Interface/SaveSessionOnClose");
-	QString PreferencesDialog::last_session = QStringLiteral("Interface/LastSession");
-	QString PreferencesDialog::show_cue_code = QStringLiteral("Interface/ShowCueCode");
-	QString PreferencesDialog::splitter_position = QStringLiteral("Interface/SplitterPosition");
-	QString PreferencesDialog::window_geometry = QStringLiteral("Interface/WindowGeometry");
-	QString PreferencesDialog::window_state = QStringLiteral("Interface/WindowState");
-
-	// "Devices" section
-	QString PreferencesDialog::devices = QStringLiteral("Devices");
-	QString PreferencesDialog::device_autoconnect = QStringLiteral("Autoconnect");
-	QString PreferencesDialog::device_capacity = QStringLiteral("Capacity");
-	QString PreferencesDialog::device_port = QStringLiteral("Port");
-	QString PreferencesDialog::device_real_time_refresh = QStringLiteral("RealTimeRefresh");
-
-	// Device section map
-	QString PreferencesDialog::section_map = QStringLiteral("SectionMap");
-	QString PreferencesDialog::section_map_local = QStringLiteral("Local");
-	QString PreferencesDialog::section_map_remote = QStringLiteral("Remote");
-
-	// "Palettes" section
-	QString PreferencesDialog::palettes = QStringLiteral("Palettes");
-	QString PreferencesDialog::palette_base_color = QStringLiteral("BaseColor");
-	QString PreferencesDialog::palette_colors = QStringLiteral("Colors");
-	QString PreferencesDialog::palette_mirror = QStringLiteral("Mirror");
-	QString PreferencesDialog::palette_name = QStringLiteral("Name");
-	QString PreferencesDialog::palette_num_colors = QStringLiteral("ColorCount");
-	QString PreferencesDialog::palette_target_color = QStringLiteral("TargetColor");
-	QString PreferencesDialog::palette_type = QStringLiteral("Type");
-	QString PreferencesDialog::palette_start = QStringLiteral("Start");
-	QString PreferencesDialog::palette_length = QStringLiteral("Length");
-	QString PreferencesDialog::palette_thumbnail = QStringLiteral("Thumbnail");
-
-	// "Show" section
-	QString PreferencesDialog::event_history_max = QStringLiteral("Interface/EventHistoryMax");
-	QString PreferencesDialog::events_trigger_device_updates = QStringLiteral("Interface/EventsTriggerDeviceUpdates");
-
 	PreferencesDialog::PreferencesDialog(QWidget *parent) : QDialog(parent), ui(new Ui::PreferencesDialog) {
 
 		setWindowIcon(QIcon("qrc:/../../../docsrc/images/logo.png"));
@@ -68,6 +15,9 @@ namespace PixelMaestroStudio {
 
 		// Interface settings
 		ui->pixelShapeComboBox->setCurrentIndex(settings_.value(pixel_shape, 1).toInt());		// Default to square pixels
+		ui->previewFrameRateSpinBox->setValue(settings_.value(preview_frame_rate, 0).toInt());	// Default to the display's refresh rate
+		ui->renderModeComboBox->setCurrentIndex(settings_.value(render_mode, 1).toInt());		// Default to framebuffer rendering
+		ui->compositeSectionsCheckBox->setChecked(settings_.value(composite_sections, false).toBool());	// Default to one widget per Section
 		ui->saveSessionCheckBox->setChecked(settings_.value(save_session, true).toBool());		// Default to old session
 
 		// Maestro settings
@@ -75,10 +25,17 @@ namespace PixelMaestroStudio {
 		ui->refreshTimeEdit->setTime(QTime::fromMSecsSinceStartOfDay(settings_.value(refresh_rate, 50).toInt()));				// Default to 50 ms
 		ui->pauseOnStartCheckBox->setChecked(settings_.value(pause_on_start, false).toBool());	// Default to run on start
 		ui->gridWidthSpinBox->setValue(settings_.value(num_sections_per_row, 1).toInt());
+		ui->simulationThreadCheckBox->setChecked(settings_.value(simulation_thread, false).toBool());	// Default to updating on the GUI thread
+		ui->hiddenRefreshSpinBox->setValue(settings_.value(hidden_refresh_rate, 0).toInt());	// Default to the normal refresh rate
+		ui->parallelSectionsCheckBox->setChecked(settings_.value(parallel_sections, false).toBool());	// Default to updating Sections one at a time
 
 		// Show settings
 		ui->eventHistorySizeSpinBox->setValue(settings_.value(event_history_max, 200).toInt());	// Default to 200
 		ui->eventsTriggerDeviceUpdateCheckBox->setChecked(settings_.value(events_trigger_device_updates, false).toBool());	// Default to false
+
+		// Monitoring settings
+		ui->metricsCheckBox->setChecked(settings_.value(metrics_enabled, false).toBool());	// Default to no metrics server
+		ui->metricsPortSpinBox->setValue(settings_.value(metrics_port, MetricsServer::DEFAULT_PORT).toInt());
 	}
 
 	void PreferencesDialog::on_buttonBox_accepted() {
@@ -86,15 +43,25 @@ namespace PixelMaestroStudio {
 		settings_.setValue(refresh_rate, ui->refreshTimeEdit->time().msecsSinceStartOfDay());
 		settings_.setValue(num_sections, ui->numSectionsSpinBox->value());
 		settings_.setValue(pause_on_start, ui->pauseOnStartCheckBox->isChecked());
+		settings_.setValue(simulation_thread, ui->simulationThreadCheckBox->isChecked());
+		settings_.setValue(hidden_refresh_rate, ui->hiddenRefreshSpinBox->value());
+		settings_.setValue(parallel_sections, ui->parallelSectionsCheckBox->isChecked());
 
 		// Save interface settings
 		settings_.setValue(pixel_shape, ui->pixelShapeComboBox->currentIndex());
+		settings_.setValue(preview_frame_rate, ui->previewFrameRateSpinBox->value());
+		settings_.setValue(render_mode, ui->renderModeComboBox->currentIndex());
+		settings_.setValue(composite_sections, ui->compositeSectionsCheckBox->isChecked());
 		settings_.setValue(save_session, ui->saveSessionCheckBox->isChecked());
 		settings_.setValue(num_sections_per_row, ui->gridWidthSpinBox->value());
 
 		// Save Show settings
 		settings_.setValue(event_history_max, ui->eventHistorySizeSpinBox->value());
 		settings_.setValue(events_trigger_device_updates, ui->eventsTriggerDeviceUpdateCheckBox->isChecked());
+
+		// Save monitoring settings
+		settings_.setValue(metrics_enabled, ui->metricsCheckBox->isChecked());
+		settings_.setValue(metrics_port, ui->metricsPortSpinBox->value());
 	}
 
 	PreferencesDialog::~PreferencesDialog() {
@@ -37,17 +37,26 @@ namespace PixelMaestroStudio {
 			static QString event_history_max;
 			static QString events_trigger_device_updates;
 
+			static QString composite_sections;
+			static QString hidden_refresh_rate;
 			static QString last_cuefile_directory;
 			static QString last_session;
 			static QString main_window_option;
 			static QString num_sections;
 			static QString num_sections_per_row;
+			static QString parallel_sections;
 			static QString pause_on_start;
 			static QString show_cue_code;
+			static QString simulation_thread;
+
+			static QString metrics_enabled;
+			static QString metrics_port;
 
 			static QString pixel_padding;
 			static QString pixel_shape;
+			static QString preview_frame_rate;
 			static QString refresh_rate;
+			static QString render_mode;
 			static QString save_session;
 			static QString separate_window_option;
 			static QString splitter_position;
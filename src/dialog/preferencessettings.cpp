@@ -0,0 +1,73 @@
+/*
+ * PreferencesDialog - Names of each setting stored in QSettings.
+ * Kept apart from the dialog itself so that tools without a GUI, like the Runner, can read the same settings.
+ */
+
+#include "preferencesdialog.h"
+
+namespace PixelMaestroStudio {
+
+	QString PreferencesDialog::delimiter = QStringLiteral("|");
+	QString PreferencesDialog::sub_delimiter = QStringLiteral(",");
+
+	// "Files" section
+	QString PreferencesDialog::last_cuefile_directory = QStringLiteral("Files/LastCuefileDirectory");
+
+	// "Displays" section
+	QString PreferencesDialog::separate_window_option = QStringLiteral("Displays/SeparateWindow");
+	QString PreferencesDialog::main_window_option = QStringLiteral("Displays/MainWindow");
+
+	// "Maestro" section
+	QString PreferencesDialog::hidden_refresh_rate = QStringLiteral("Maestro/HiddenRefresh");
+	QString PreferencesDialog::num_sections = QStringLiteral("Maestro/NumSections");
+	QString PreferencesDialog::num_sections_per_row = QStringLiteral("Maestro/NumSectionsPerRow");
+	QString PreferencesDialog::parallel_sections = QStringLiteral("Maestro/ParallelSections");
+	QString PreferencesDialog::refresh_rate = QStringLiteral("Maestro/Refresh");
+	QString PreferencesDialog::simulation_thread = QStringLiteral("Maestro/SimulationThread");
+
+	// "Monitoring" section
+	QString PreferencesDialog::metrics_enabled = QStringLiteral("Monitoring/MetricsEnabled");
+	QString PreferencesDialog::metrics_port = QStringLiteral("Monitoring/MetricsPort");
+
+	// "Interface" section
+	QString PreferencesDialog::composite_sections = QStringLiteral("Interface/CompositeSections");
+	QString PreferencesDialog::pause_on_start = QStringLiteral("Interface/PauseOnStart");
+	QString PreferencesDialog::pixel_shape = QStringLiteral("Interface/Shape");
+	QString PreferencesDialog::preview_frame_rate = QStringLiteral("Interface/PreviewFrameRate");
+	QString PreferencesDialog::render_mode = QStringLiteral("Interface/RenderMode");
+	QString PreferencesDialog::save_session = QStringLiteral("Interface/SaveSessionOnClose");
+	QString PreferencesDialog::last_session = QStringLiteral("Interface/LastSession");
+	QString PreferencesDialog::show_cue_code = QStringLiteral("Interface/ShowCueCode");
+	QString PreferencesDialog::splitter_position = QStringLiteral("Interface/SplitterPosition");
+	QString PreferencesDialog::window_geometry = QStringLiteral("Interface/WindowGeometry");
+	QString PreferencesDialog::window_state = QStringLiteral("Interface/WindowState");
+
+	// "Devices" section
+	QString PreferencesDialog::devices = QStringLiteral("Devices");
+	QString PreferencesDialog::device_autoconnect = QStringLiteral("Autoconnect");
+	QString PreferencesDialog::device_capacity = QStringLiteral("Capacity");
+	QString PreferencesDialog::device_port = QStringLiteral("Port");
+	QString PreferencesDialog::device_real_time_refresh = QStringLiteral("RealTimeRefresh");
+
+	// Device section map
+	QString PreferencesDialog::section_map = QStringLiteral("SectionMap");
+	QString PreferencesDialog::section_map_local = QStringLiteral("Local");
+	QString PreferencesDialog::section_map_remote = QStringLiteral("Remote");
+
+	// "Palettes" section
+	QString PreferencesDialog::palettes = QStringLiteral("Palettes");
+	QString PreferencesDialog::palette_base_color = QStringLiteral("BaseColor");
+	QString PreferencesDialog::palette_colors = QStringLiteral("Colors");
+	QString PreferencesDialog::palette_mirror = QStringLiteral("Mirror");
+	QString PreferencesDialog::palette_name = QStringLiteral("Name");
+	QString PreferencesDialog::palette_num_colors = QStringLiteral("ColorCount");
+	QString PreferencesDialog::palette_target_color = QStringLiteral("TargetColor");
+	QString PreferencesDialog::palette_type = QStringLiteral("Type");
+	QString PreferencesDialog::palette_start = QStringLiteral("Start");
+	QString PreferencesDialog::palette_length = QStringLiteral("Length");
+	QString PreferencesDialog::palette_thumbnail = QStringLiteral("Thumbnail");
+
+	// "Show" section
+	QString PreferencesDialog::event_history_max = QStringLiteral("Interface/EventHistoryMax");
+	QString PreferencesDialog::events_trigger_device_updates = QStringLiteral("Interface/EventsTriggerDeviceUpdates");
+}
@@ -1,5 +1,6 @@
 #include <QAbstractButton>
 #include <QMessageBox>
+#include <QMutexLocker>
 #include "sectionmapdialog.h"
 #include "ui_sectionmapdialog.h"
 #include "widget/devicecontrolwidget.h"
@@ -15,9 +16,13 @@ namespace PixelMaestroStudio {
 		// If the model hasn't been initialized, initialize it
 		if (device.section_map_model == nullptr) {
 			MaestroControlWidget* mcw = dynamic_cast<MaestroControlWidget*>(parent->parentWidget()->parentWidget()->parentWidget()->parentWidget()->parentWidget()->parentWidget());
-			Maestro& maestro = mcw->get_maestro_controller()->get_maestro();
+			uint8_t num_sections;
+			{
+				QMutexLocker locker(mcw->get_maestro_controller()->get_maestro_mutex());
+				num_sections = mcw->get_maestro_controller()->get_maestro().get_num_sections();
+			}
 			device.section_map_model = new SectionMapModel();
-			for (int i = 0; i < maestro.get_num_sections(); i++) {
+			for (int i = 0; i < num_sections; i++) {
 				device.section_map_model->add_section();
 			}
 		}
@@ -45,9 +50,13 @@ namespace PixelMaestroStudio {
 				// Reinitialize the Section's model and reset the table view
 				delete device_.section_map_model;
 				MaestroControlWidget* mcw = dynamic_cast<MaestroControlWidget*>(parentWidget()->parentWidget()->parentWidget()->parentWidget()->parentWidget()->parentWidget());
-				Maestro& maestro = mcw->get_maestro_controller()->get_maestro();
+				uint8_t num_sections;
+				{
+					QMutexLocker locker(mcw->get_maestro_controller()->get_maestro_mutex());
+					num_sections = mcw->get_maestro_controller()->get_maestro().get_num_sections();
+				}
 				device_.section_map_model = new SectionMapModel();
-				for (int i = 0; i < maestro.get_num_sections(); i++) {
+				for (int i = 0; i < num_sections; i++) {
 					device_.section_map_model->add_section();
 				}
 				initialize();
@@ -2,9 +2,13 @@
 #include "core/maestro.h"
 #include "maestrodrawingarea.h"
 #include "dialog/preferencesdialog.h"
+#include "utility/performancemonitor.h"
+#include "utility/tracerecorder.h"
 #include <QElapsedTimer>
 #include <QGridLayout>
+#include <QPainter>
 #include <QTimer>
+#include <QWindow>
 
 using namespace PixelMaestro;
 
@@ -20,14 +24,27 @@ namespace PixelMaestroStudio {
 		// Hide frame by default
 		this->setFrameStyle(QFrame::Box | QFrame::Plain);
 		this->setStyleSheet("color: #333333;");
+
+		// In composite mode, this widget handles hover and click events for every Section
+		QSettings settings;
+		composite_ = settings.value(PreferencesDialog::composite_sections, false).toBool();
+		this->setMouseTracking(composite_);
 	}
 
 	/**
 	 * Adds a new SectionDrawingArea to the widget.
+	 * In composite mode, the Section is drawn directly onto this widget and no SectionDrawingArea is created.
 	 * @param section Section to draw.
-	 * @return New SectionDrawingArea.
+	 * @return New SectionDrawingArea, or nullptr in composite mode.
 	 */
 	SectionDrawingArea* MaestroDrawingArea::add_section_drawing_area(Section& section, const uint8_t section_id) {
+		if (composite_) {
+			section_renderers_.push_back(QSharedPointer<SectionRenderer>(new SectionRenderer(maestro_controller_, section, section_id)));
+			layout_section_cells();
+			QFrame::update();
+			return nullptr;
+		}
+
 		section_drawing_areas_.push_back(
 			QSharedPointer<SectionDrawingArea>(
 				new SectionDrawingArea(this, section, section_id)
@@ -43,6 +60,88 @@ namespace PixelMaestroStudio {
 		return dynamic_cast<SectionDrawingArea*>(drawing_area);
 	}
 
+	/**
+	 * Handles mouse input over a Section.
+	 * When Canvas is enabled, users can draw onto the Section using the mouse.
+	 * Left-click activates and right-click deactiviates.
+	 * @param section The Section under the cursor.
+	 * @param pixel The Pixel under the cursor.
+	 * @param buttons The mouse buttons being held.
+	 */
+	void MaestroDrawingArea::edit_canvas(Section& section, const Point& pixel, Qt::MouseButtons buttons) {
+		Canvas* canvas = section.get_canvas();
+		if (canvas == nullptr) return;
+
+		// If there's a MaestroControlWidget, use run_cue instead of modifying the Canvas directly.
+		MaestroControlWidget* widget = maestro_control_widget_;
+		if (widget == nullptr) return;
+
+		// Set the cursor location in the MaestroControlWidget
+		Point origin = pixel;
+		widget->canvas_control_widget_->set_canvas_origin(origin);
+
+		// Check to see if paint mode is enabled.
+		if (widget->canvas_control_widget_->get_painting_enabled()) {
+			if (buttons == Qt::LeftButton) {
+				widget->run_cue(
+					widget->canvas_handler->draw_point(
+						widget->section_control_widget_->get_section_index(),
+						widget->section_control_widget_->get_layer_index(),
+						canvas->get_current_frame_index(),
+						widget->canvas_control_widget_->get_selected_color_index(),
+						pixel.x,
+						pixel.y)
+				);
+			}
+			else if (buttons == Qt::RightButton) {
+				widget->run_cue(
+					widget->canvas_handler->erase_point(
+						widget->section_control_widget_->get_section_index(),
+						widget->section_control_widget_->get_layer_index(),
+						canvas->get_current_frame_index(),
+						pixel.x,
+						pixel.y)
+				);
+			}
+		}
+
+		if (widget->canvas_control_widget_->get_replace_enabled()) {
+			if (buttons == Qt::LeftButton) {
+				widget->canvas_control_widget_->on_drawButton_clicked();
+			}
+		}
+	}
+
+	/**
+	 * Tracks when the window containing the DrawingArea is minimized, covered, or shown again.
+	 * @param watched Window that received the event.
+	 * @param event Event parameters.
+	 * @return False, so that the window still handles the event.
+	 */
+	bool MaestroDrawingArea::eventFilter(QObject* watched, QEvent* event) {
+		switch (event->type()) {
+			case QEvent::Expose:
+			case QEvent::Hide:
+			case QEvent::Show:
+			case QEvent::WindowStateChange:
+				update_exposed();
+				break;
+			default:
+				break;
+		}
+
+		return QFrame::eventFilter(watched, event);
+	}
+
+	/**
+	 * Returns whether the DrawingArea is visible on screen.
+	 * DrawingAreas that are hidden, minimized, or fully covered don't need to be redrawn.
+	 * @return True if visible.
+	 */
+	bool MaestroDrawingArea::get_exposed() const {
+		return exposed_;
+	}
+
 	/**
 	 * Returns this DrawingArea's MaestroControlWidget (if applicable).
 	 * @return DrawingArea's controlling widget.
@@ -51,6 +150,14 @@ namespace PixelMaestroStudio {
 		return maestro_control_widget_;
 	}
 
+	/**
+	 * Returns the MaestroController rendered by this DrawingArea.
+	 * @return DrawingArea's MaestroController.
+	 */
+	MaestroController& MaestroDrawingArea::get_maestro_controller() const {
+		return maestro_controller_;
+	}
+
 	/**
 	 * Changes the active Section, which highlights the appropriate SectionDrawingArea.
 	 * @param section Active Section.
@@ -60,6 +167,18 @@ namespace PixelMaestroStudio {
 
 		int section_id = maestro_control_widget_->section_control_widget_->get_section_index(section);
 
+		if (composite_) {
+			// Repaint the frames around the previous and new active Sections
+			if (active_section_index_ >= 0 && active_section_index_ < section_cells_.size()) {
+				QFrame::update(section_cells_[active_section_index_]);
+			}
+			active_section_index_ = section_id;
+			if (active_section_index_ >= 0 && active_section_index_ < section_cells_.size()) {
+				QFrame::update(section_cells_[active_section_index_]);
+			}
+			return;
+		}
+
 		for (uint8_t i = 0; i < section_drawing_areas_.size(); i++) {
 			if (i == section_id) {
 				section_drawing_areas_[i]->draw_frame(SectionDrawingArea::FrameType::Active);
@@ -70,12 +189,205 @@ namespace PixelMaestroStudio {
 		}
 	}
 
+	/**
+	 * Finds the Section at the specified location in composite mode.
+	 * @param pos Location in widget coordinates.
+	 * @return Index of the Section, or -1 if there is no Section at the location.
+	 */
+	int MaestroDrawingArea::get_section_at(const QPoint& pos) const {
+		for (int i = 0; i < section_cells_.size(); i++) {
+			if (section_cells_[i].contains(pos)) {
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	/**
+	 * Stops redrawing once the DrawingArea is hidden.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::hideEvent(QHideEvent* event) {
+		QFrame::hideEvent(event);
+		update_exposed();
+	}
+
+	/**
+	 * Divides the widget into a grid of cells, one per Section, matching the layout used by SectionDrawingAreas.
+	 */
+	void MaestroDrawingArea::layout_section_cells() {
+		section_cells_.clear();
+		if (section_renderers_.isEmpty()) return;
+
+		QSettings settings;
+		int grid_width = settings.value(PreferencesDialog::num_sections_per_row, 1).toInt();
+		int num_columns = qMin(grid_width, section_renderers_.size());
+		int num_rows = (section_renderers_.size() + grid_width - 1) / grid_width;
+
+		QRect area = this->contentsRect().marginsRemoved(section_layout_->contentsMargins());
+		int spacing_x = qMax(0, section_layout_->horizontalSpacing());
+		int spacing_y = qMax(0, section_layout_->verticalSpacing());
+		int cell_width = (area.width() - (spacing_x * (num_columns - 1))) / num_columns;
+		int cell_height = (area.height() - (spacing_y * (num_rows - 1))) / num_rows;
+
+		QColor background = this->palette().color(this->backgroundRole());
+		for (int i = 0; i < section_renderers_.size(); i++) {
+			int row_num = i / grid_width;
+			int column_num = i % grid_width;
+			QRect cell(area.x() + column_num * (cell_width + spacing_x),
+					   area.y() + row_num * (cell_height + spacing_y),
+					   cell_width,
+					   cell_height);
+			section_cells_.push_back(cell);
+
+			// Leave room for the Section's frame
+			section_renderers_[i]->set_bounds(cell.adjusted(1, 1, -1, -1), background);
+		}
+	}
+
+	/**
+	 * Removes the hover border in composite mode once the cursor leaves the DrawingArea.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::leaveEvent(QEvent* event) {
+		QFrame::leaveEvent(event);
+
+		if (hover_section_index_ >= 0 && hover_section_index_ < section_renderers_.size()) {
+			QRegion cursor_region = section_renderers_[hover_section_index_]->clear_cursor();
+			if (!cursor_region.isEmpty()) {
+				QFrame::update(cursor_region);
+			}
+		}
+		hover_section_index_ = -1;
+	}
+
+	/**
+	 * Handles hover and Canvas editing in composite mode.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::mouseMoveEvent(QMouseEvent* event) {
+		if (!composite_) {
+			QFrame::mouseMoveEvent(event);
+			return;
+		}
+
+		int section_index = get_section_at(event->pos());
+
+		// If the cursor left a Section, remove its hover border
+		if (section_index != hover_section_index_ && hover_section_index_ >= 0 && hover_section_index_ < section_renderers_.size()) {
+			QRegion cursor_region = section_renderers_[hover_section_index_]->clear_cursor();
+			if (!cursor_region.isEmpty()) {
+				QFrame::update(cursor_region);
+			}
+		}
+		hover_section_index_ = section_index;
+
+		if (section_index < 0) return;
+
+		SectionRenderer* renderer = section_renderers_[section_index].data();
+		QRegion cursor_region = renderer->set_cursor(event->pos());
+		if (!cursor_region.isEmpty()) {
+			QFrame::update(cursor_region);
+		}
+
+		if (event->buttons() == Qt::LeftButton || event->buttons() == Qt::RightButton) {
+			edit_canvas(renderer->get_section(), renderer->map_cursor_to_pixel(event->pos()), event->buttons());
+		}
+
+		// Drag with the middle button to pan
+		if (event->buttons() == Qt::MiddleButton) {
+			QRect area = renderer->pan(event->pos() - pan_cursor_);
+			pan_cursor_ = event->pos();
+			if (!area.isEmpty()) {
+				QFrame::update(area);
+			}
+		}
+	}
+
+	/**
+	 * Handles selecting Sections in composite mode.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::mousePressEvent(QMouseEvent* event) {
+		if (!composite_) {
+			QFrame::mousePressEvent(event);
+			return;
+		}
+
+		// Sets the clicked Section as the active Section on left click
+		int section_index = get_section_at(event->pos());
+		if (section_index >= 0 && event->buttons() == Qt::LeftButton) {
+			select_section(section_renderers_[section_index]->get_section());
+		}
+
+		pan_cursor_ = event->pos();
+		mouseMoveEvent(event);
+	}
+
+	/**
+	 * Draws every Section in composite mode.
+	 * Only Sections that intersect the event's region are redrawn.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::paintEvent(QPaintEvent* event) {
+		TraceRecorder::Span span("MaestroDrawingArea::paintEvent");
+		if (composite_) {
+			// Outside of composite mode, each SectionDrawingArea times its own paint
+			PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::Paint);
+			QPainter painter(this);
+			QRect area = event->rect();
+			for (int i = 0; i < section_renderers_.size(); i++) {
+				const QRect& cell = section_cells_[i];
+				if (!cell.intersects(area)) continue;
+
+				section_renderers_[i]->paint(painter, area);
+
+				// Draw the Section's frame. The active Section has a white frame, and inactive Sections have gray frames.
+				painter.setBrush(Qt::BrushStyle::NoBrush);
+				painter.setPen(i == active_section_index_ ? QColor(0xFF, 0xFF, 0xFF) : QColor(0x80, 0x80, 0x80));
+				painter.drawRect(cell.adjusted(0, 0, -1, -1));
+			}
+		}
+
+		QFrame::paintEvent(event);
+	}
+
 	/**
 	 * Removes a Section drawing areas.
 	 * @param Section Pointer to the Section to remove. Leave blank to remove all Sections.
 	 */
 	void MaestroDrawingArea::remove_section_drawing_areas() {
 		section_drawing_areas_.clear();
+		section_renderers_.clear();
+		section_cells_.clear();
+		hover_section_index_ = -1;
+		QFrame::update();
+	}
+
+	/**
+	 * Recalculates the Section grid in composite mode.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::resizeEvent(QResizeEvent* event) {
+		QFrame::resizeEvent(event);
+
+		if (composite_) {
+			layout_section_cells();
+		}
+	}
+
+	/**
+	 * Sets the specified Section as the active Section.
+	 * @param section Section to activate.
+	 */
+	void MaestroDrawingArea::select_section(Section& section) {
+		if (maestro_control_widget_ == nullptr) return;
+
+		Section& active_section = maestro_control_widget_->section_control_widget_->get_active_section();
+		if (&active_section != &section) {
+			maestro_control_widget_->section_control_widget_->set_active_section(&section);
+		}
 	}
 
 	void MaestroDrawingArea::set_locked(bool locked) {
@@ -96,13 +408,87 @@ namespace PixelMaestroStudio {
 		this->maestro_control_widget_ = widget;
 	}
 
+	/**
+	 * Starts watching the containing window for visibility changes.
+	 * The native window doesn't exist until the widget is first shown.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::showEvent(QShowEvent* event) {
+		QFrame::showEvent(event);
+
+		QWidget* window = this->window();
+		window->installEventFilter(this);
+		if (window->windowHandle() != nullptr) {
+			window->windowHandle()->installEventFilter(this);
+		}
+		update_exposed();
+	}
+
+	/**
+	 * Handles zooming and panning with the mouse wheel in composite mode.
+	 * @param event Event parameters.
+	 */
+	void MaestroDrawingArea::wheelEvent(QWheelEvent* event) {
+		int section_index = composite_ ? get_section_at(event->pos()) : -1;
+		if (section_index < 0) {
+			QFrame::wheelEvent(event);
+			return;
+		}
+
+		QRect area = section_renderers_[section_index]->scroll(*event);
+		if (area.isEmpty()) {
+			event->ignore();
+			return;
+		}
+
+		QFrame::update(area);
+	}
+
+	/**
+	 * Checks whether the DrawingArea is still visible on screen.
+	 * If it just became visible, its Sections are brought up to date with the latest frame.
+	 */
+	void MaestroDrawingArea::update_exposed() {
+		bool exposed = this->isVisible() && !this->visibleRegion().isEmpty();
+		if (exposed) {
+			QWidget* window = this->window();
+			QWindow* handle = window->windowHandle();
+			exposed = !window->isMinimized() && (handle == nullptr || handle->isExposed());
+		}
+
+		if (exposed == exposed_) return;
+		exposed_ = exposed;
+
+		if (exposed_) {
+			update();
+		}
+		emit exposed_changed(exposed_);
+	}
+
 	/**
 	 * Redraws the DrawingArea.
+	 * Each Section only repaints the Pixels that changed since the last update.
 	 */
 	void MaestroDrawingArea::update() {
+		TraceRecorder::Span span("MaestroDrawingArea::update");
+		if (composite_) {
+			// Collect every change into one region so that all Sections are repainted in a single pass
+			QRegion region;
+			for (int i = 0; i < section_renderers_.size(); i++) {
+				QRect area = section_renderers_[i]->refresh();
+				if (!area.isEmpty()) {
+					region += area;
+				}
+			}
+			if (!region.isEmpty()) {
+				QFrame::update(region);
+			}
+			return;
+		}
+
 		// Update all DrawingAreas
 		for (uint16_t i = 0; i < section_drawing_areas_.size(); i++) {
-			section_drawing_areas_[i]->update();
+			section_drawing_areas_[i]->refresh();
 		}
 	}
 }
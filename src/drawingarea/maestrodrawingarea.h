@@ -11,10 +11,18 @@
 #include "core/pixel.h"
 #include "core/section.h"
 #include "sectiondrawingarea.h"
+#include "sectionrenderer.h"
 #include "widget/maestrocontrolwidget.h"
 #include <QElapsedTimer>
+#include <QEvent>
 #include <QGridLayout>
+#include <QHideEvent>
+#include <QMouseEvent>
+#include <QPaintEvent>
+#include <QResizeEvent>
+#include <QShowEvent>
 #include <QTimer>
+#include <QWheelEvent>
 #include <QWidget>
 #include <vector>
 
@@ -32,15 +40,23 @@ namespace PixelMaestroStudio {
 			MaestroDrawingArea(QWidget* parent, MaestroController& maestro_controller);
 			~MaestroDrawingArea() = default;
 			SectionDrawingArea* add_section_drawing_area(Section& section, const uint8_t section_id);
+			void edit_canvas(Section& section, const Point& pixel, Qt::MouseButtons buttons);
 			MaestroControlWidget* get_maestro_control_widget() const;
+			MaestroController& get_maestro_controller() const;
 			void frame_active_section(Section& section);
+			bool get_exposed() const;
 			void remove_section_drawing_areas();
+			void select_section(Section& section);
 			void set_locked(bool locked);
 			void set_maestro_control_widget(MaestroControlWidget* widget);
 
 		public slots:
 			void update();
 
+		signals:
+			/// Emitted when the DrawingArea becomes visible on screen, or stops being visible.
+			void exposed_changed(bool exposed);
+
 		protected:
 			/// The MaestroControlWidget controlling this DrawingArea (if applicable).
 			MaestroControlWidget* maestro_control_widget_ = nullptr;
@@ -51,12 +67,47 @@ namespace PixelMaestroStudio {
 			/// The SectionDrawingAreas managed by this DrawingArea
 			QVector<QSharedPointer<SectionDrawingArea>> section_drawing_areas_;
 
+			bool eventFilter(QObject* watched, QEvent* event) override;
+			void hideEvent(QHideEvent* event) override;
+			void leaveEvent(QEvent* event) override;
+			void mouseMoveEvent(QMouseEvent* event) override;
+			void mousePressEvent(QMouseEvent* event) override;
+			void paintEvent(QPaintEvent* event) override;
+			void resizeEvent(QResizeEvent* event) override;
+			void showEvent(QShowEvent* event) override;
+			void wheelEvent(QWheelEvent* event) override;
+
 		private:
+			/// Index of the active Section. Used for highlighting in composite mode.
+			int active_section_index_ = -1;
+
+			/// If true, every Section is drawn directly onto this widget in a single pass instead of using SectionDrawingAreas.
+			bool composite_ = false;
+
+			/// Whether any part of the DrawingArea is currently visible on screen.
+			bool exposed_ = false;
+
+			/// Index of the Section under the mouse cursor in composite mode.
+			int hover_section_index_ = -1;
+
+			/// The last cursor position while panning with the middle mouse button in composite mode.
+			QPoint pan_cursor_;
+
 			/// Layout containing SectionDrawingAreas.
 			QGridLayout* section_layout_ = nullptr;
 
+			/// The area of the widget assigned to each Section in composite mode.
+			QVector<QRect> section_cells_;
+
+			/// Renderers for each Section in composite mode.
+			QVector<QSharedPointer<SectionRenderer>> section_renderers_;
+
 			/// Tracks the active Section in order to provide highlighting.
 			Section* active_section_ = nullptr;
+
+			int get_section_at(const QPoint& pos) const;
+			void layout_section_cells();
+			void update_exposed();
 	};
 }
 
@@ -1,10 +1,9 @@
 #include <QPainter>
-#include <QSettings>
 #include "sectiondrawingarea.h"
-#include "dialog/preferencesdialog.h"
+#include "utility/performancemonitor.h"
 
 namespace PixelMaestroStudio {
-	SectionDrawingArea::SectionDrawingArea(QWidget* parent, Section& section, uint8_t section_id) : QFrame(parent), maestro_drawing_area_(*dynamic_cast<MaestroDrawingArea*>(parent)), section_(section) {
+	SectionDrawingArea::SectionDrawingArea(QWidget* parent, Section& section, uint8_t section_id) : QFrame(parent), maestro_drawing_area_(*dynamic_cast<MaestroDrawingArea*>(parent)), section_(section), renderer_(maestro_drawing_area_.get_maestro_controller(), section, section_id) {
 		this->section_id_ = section_id;
 
 		// Enable mouse tracking
@@ -15,9 +14,6 @@ namespace PixelMaestroStudio {
 			this->setFrameStyle(QFrame::Box | QFrame::Plain);
 			this->draw_frame(FrameType::Inactive);
 		}
-
-		QSettings settings;
-		this->pixel_shape_ = settings.value(PreferencesDialog::pixel_shape, 1).toInt();
 	}
 
 	/*
@@ -52,32 +48,6 @@ namespace PixelMaestroStudio {
 		return this->section_;
 	}
 
-	/**
-	 * Translates the mouse cursor to a PixelMaestro Pixel.
-	 * @param cursor Mouse cursor coordinates.
-	 * @return Pixel coordinate.
-	 */
-	Point SectionDrawingArea::map_cursor_to_pixel(const QPoint cursor) {
-		uint16_t x = cursor.x() - section_cursor_.x;
-		uint16_t y = cursor.y() - section_cursor_.y;
-
-		if (radius_ > 0) {
-			x /= radius_;
-			y /= radius_;
-			if (x >= section_.get_dimensions().x) {
-				x = section_.get_dimensions().x - 1;
-			}
-			if (y >= section_.get_dimensions().y) {
-				y = section_.get_dimensions().y - 1;
-			}
-
-			return Point(x, y);
-		}
-		else {
-			return Point(0, 0);
-		}
-	}
-
 	/**
 	 * Handles mouse clicks.
 	 * When Canvas is enabled, users can draw onto the Section using the mouse.
@@ -85,51 +55,22 @@ namespace PixelMaestroStudio {
 	 * @param event Event parameters.
 	 */
 	void SectionDrawingArea::mouseMoveEvent(QMouseEvent *event) {
-		// Store the cursor position for Canvas editing
-		cursor_pos_ = event->pos();
+		// Store the cursor position for Canvas editing and move the hover border
+		QRegion cursor_region = renderer_.set_cursor(event->pos());
+		if (!cursor_region.isEmpty()) {
+			QFrame::update(cursor_region);
+		}
 
 		if (event->buttons() == Qt::LeftButton || event->buttons() == Qt::RightButton) {
-			Canvas* canvas = section_.get_canvas();
-			if (canvas != nullptr) {
-				Point pixel = map_cursor_to_pixel(cursor_pos_);
-
-				// If there's a MaestroControlWidget, use run_cue instead of modifying the Canvas directly.
-				MaestroControlWidget* widget = maestro_drawing_area_.get_maestro_control_widget();
-				if (widget != nullptr) {
-					// Set the cursor location in the MaestroControlWidget
-					widget->canvas_control_widget_->set_canvas_origin(pixel);
-
-					// Check to see if paint mode is enabled.
-					if (widget->canvas_control_widget_->get_painting_enabled()) {
-						if (event->buttons() == Qt::LeftButton) {
-							widget->run_cue(
-								widget->canvas_handler->draw_point(
-									widget->section_control_widget_->get_section_index(),
-									widget->section_control_widget_->get_layer_index(),
-									canvas->get_current_frame_index(),
-									widget->canvas_control_widget_->get_selected_color_index(),
-									pixel.x,
-									pixel.y)
-							);
-						}
-						else if (event->buttons() == Qt::RightButton) {
-							widget->run_cue(
-								widget->canvas_handler->erase_point(
-									widget->section_control_widget_->get_section_index(),
-									widget->section_control_widget_->get_layer_index(),
-									canvas->get_current_frame_index(),
-									pixel.x,
-									pixel.y)
-							);
-						}
-					}
-
-					if (widget->canvas_control_widget_->get_replace_enabled()) {
-						if (event->buttons() == Qt::LeftButton) {
-							widget->canvas_control_widget_->on_drawButton_clicked();
-						}
-					}
-				}
+			maestro_drawing_area_.edit_canvas(section_, renderer_.map_cursor_to_pixel(event->pos()), event->buttons());
+		}
+
+		// Drag with the middle button to pan
+		if (event->buttons() == Qt::MiddleButton) {
+			QRect area = renderer_.pan(event->pos() - pan_cursor_);
+			pan_cursor_ = event->pos();
+			if (!area.isEmpty()) {
+				QFrame::update(area);
 			}
 		}
 	}
@@ -141,108 +82,57 @@ namespace PixelMaestroStudio {
 	void SectionDrawingArea::mousePressEvent(QMouseEvent *event) {
 		// Sets the current Section as the active Section on left click
 		if (event->buttons() == Qt::LeftButton) {
-			Section& active_section = maestro_drawing_area_.get_maestro_control_widget()->section_control_widget_->get_active_section();
-			if (&active_section != &this->section_) {
-				maestro_drawing_area_.get_maestro_control_widget()->section_control_widget_->set_active_section(&this->section_);
-			}
+			maestro_drawing_area_.select_section(section_);
 		}
 
+		pan_cursor_ = event->pos();
 		mouseMoveEvent(event);
 	}
 
 	/**
 	 * Handles drawing the Section.
+	 * Only the Pixels covered by the event's region are redrawn.
 	 * @param event Event parameters.
 	 */
 	void SectionDrawingArea::paintEvent(QPaintEvent *event) {
+		PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::Paint);
 		QPainter painter(this);
-		painter.setRenderHint(QPainter::Antialiasing);
+		renderer_.paint(painter, event->rect());
 
-		/*
-		 * Check to see if the Section's changed sizes.
-		 * If so, recalculate the drawing area's dimensions.
-		 */
-		if (last_pixel_count_ != section_.get_dimensions().size()) {
-			resizeEvent(nullptr);
-			last_pixel_count_ = section_.get_dimensions().size();
-		}
+		QFrame::paintEvent(event);
+	}
 
-		/*
-		 * Draw each Pixel.
-		 * For each Pixel, translate it's RGB color into a QColor.
-		 * Then, depending on the user's preferenes, draw it as either a circle or a square.
-		 */
-		for (uint16_t row = 0; row < section_.get_dimensions().y; row++) {
-			for (uint16_t column = 0; column < section_.get_dimensions().x; column++) {
-				Colors::RGB rgb = section_.get_pixel_color(column, row);
-				QColor qcolor;
-				QBrush brush;
-				QRect rect;
-
-				qcolor.setRgb(rgb.r, rgb.g, rgb.b);
-				brush.setColor(qcolor);
-				brush.setStyle(Qt::BrushStyle::SolidPattern);
-
-				/*
-				 * Draw the Pixel.
-				 * First, calculate the bounds of the Pixel.
-				 * Then, set the color of the pen to the color of the Pixel.
-				 * Finally, draw the Pixel to the screen.
-				 */
-				rect.setRect(section_cursor_.x + (column * radius_), section_cursor_.y + (row * radius_), radius_, radius_);
-				painter.setBrush(brush);
-
-				// Set Pen style.
-				// If Canvas is enabled, draw a light border around the Pixel if the cursor is over it
-				painter.setPen(Qt::PenStyle::NoPen);
-				if (section_.get_canvas() != nullptr) {
-					Point pixel_pos = map_cursor_to_pixel(cursor_pos_);
-					if (pixel_pos.x == column && pixel_pos.y == row) {
-						painter.setPen(Qt::PenStyle::SolidLine);
-					}
-				}
-
-				/*
-				 * Determine which shape to draw.
-				 * If none is set, default to "Square"
-				 */
-				switch (pixel_shape_) {
-					case 0:	// Circle
-						painter.drawEllipse(rect);
-						break;
-					case 1:	// Rect
-						painter.drawRect(rect);
-						break;
-				}
-			}
+	/**
+	 * Checks the Section for changes and schedules a repaint of only the Pixels that changed.
+	 * If nothing changed, no repaint occurs.
+	 */
+	void SectionDrawingArea::refresh() {
+		QRect area = renderer_.refresh();
+		if (!area.isEmpty()) {
+			QFrame::update(area);
 		}
-
-		QFrame::paintEvent(event);
 	}
 
 	/**
 	 * Handles resizing the widget.
 	 * On each resize, the widget recalculates the optimal size of each Pixel so that the entire Section fits.
-	 * It also centers the Section.
 	 * @param event Event parameters.
 	 */
 	void SectionDrawingArea::resizeEvent(QResizeEvent *event) {
-		QSize widget_size = this->size();
-
-		// Next, get the max size of each Pixel via the window size.
-		uint16_t max_pixel_width = static_cast<uint16_t>(widget_size.width() / section_.get_dimensions().x);
-		uint16_t max_pixel_height = static_cast<uint16_t>(widget_size.height() / section_.get_dimensions().y);
+		renderer_.set_bounds(this->rect(), this->palette().color(this->backgroundRole()));
+	}
 
-		// Find the smaller dimension
-		if (max_pixel_width < max_pixel_height) {
-			radius_ = max_pixel_width;
-		}
-		else {
-			radius_ = max_pixel_height;
+	/**
+	 * Handles zooming and panning with the mouse wheel.
+	 * @param event Event parameters.
+	 */
+	void SectionDrawingArea::wheelEvent(QWheelEvent *event) {
+		QRect area = renderer_.scroll(*event);
+		if (area.isEmpty()) {
+			event->ignore();
+			return;
 		}
 
-		// Sets the Section's starting point so that it's aligned horizontally and vertically.
-		section_cursor_.x = (widget_size.width() - (section_.get_dimensions().x * radius_)) / 2;
-		section_cursor_.y = (widget_size.height() - (section_.get_dimensions().y * radius_)) / 2;
+		QFrame::update(area);
 	}
 }
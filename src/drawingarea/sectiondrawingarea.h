@@ -6,9 +6,11 @@
 #include <QPaintEvent>
 #include <QPoint>
 #include <QResizeEvent>
+#include <QWheelEvent>
 #include <QWidget>
 #include "core/section.h"
 #include "drawingarea/maestrodrawingarea.h"
+#include "drawingarea/sectionrenderer.h"
 
 namespace PixelMaestroStudio {
 	class MaestroDrawingArea;
@@ -25,6 +27,7 @@ namespace PixelMaestroStudio {
 			~SectionDrawingArea() = default;
 			void draw_frame(FrameType type);
 			Section& get_section() const;
+			void refresh();
 
 		protected:
 			Section& section_;
@@ -33,30 +36,20 @@ namespace PixelMaestroStudio {
 			void mousePressEvent(QMouseEvent* event) override;
 			void paintEvent(QPaintEvent *event) override;
 			void resizeEvent(QResizeEvent *event) override;
+			void wheelEvent(QWheelEvent *event) override;
 
 		private:
-			/// The last location of the mouse cursor.
-			QPoint cursor_pos_;
-
-			/// The Section's last recorded size. Used to determine when to resize the output.
-			uint32_t last_pixel_count_ = 0;
-
 			/// The parent MaestroDrawingArea.
 			MaestroDrawingArea& maestro_drawing_area_;
 
-			/// The shape that each Pixel is drawn in. Defaults to square.
-			int pixel_shape_ = 1;
+			/// The last cursor position while panning with the middle mouse button.
+			QPoint pan_cursor_;
 
-			/// The size of each rendered Pixel.
-			uint16_t radius_ = 20;
-
-			/// The location where the Section will be rendered.
-			Point section_cursor_;
+			/// Draws the Section's Pixels.
+			SectionRenderer renderer_;
 
 			/// Index of the Section in the Maestro.
 			uint8_t section_id_;
-
-			Point map_cursor_to_pixel(const QPoint cursor);
 	};
 }
 
@@ -0,0 +1,545 @@
+#include <QMutexLocker>
+#include <QSettings>
+#include <QtMath>
+#include "controller/maestrocontroller.h"
+#include "dialog/preferencesdialog.h"
+#include "sectionrenderer.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * @param maestro_controller The controller managing the Section.
+	 * @param section The Section to render.
+	 * @param section_id The Section's index.
+	 */
+	SectionRenderer::SectionRenderer(MaestroController& maestro_controller, Section& section, uint8_t section_id) : maestro_controller_(maestro_controller), section_(section), section_id_(section_id) {
+		QSettings settings;
+		this->pixel_shape_ = settings.value(PreferencesDialog::pixel_shape, 1).toInt();
+		this->render_mode_ = static_cast<RenderMode>(settings.value(PreferencesDialog::render_mode, static_cast<int>(RenderMode::Framebuffer)).toInt());
+	}
+
+	/**
+	 * Copies the Section's current output from the MaestroController's shared frame into the frame buffer.
+	 * If the Section's size changed, the buffer is reallocated and the layout is recalculated.
+	 * @return Bounding box of the Pixels that changed since the last capture. Empty if nothing changed.
+	 */
+	QRect SectionRenderer::capture_frame() {
+		const MaestroFrame* snapshot = maestro_controller_.get_frame();
+
+		// Nothing to do if this frame was already captured
+		if (snapshot->get_sequence() == frame_sequence_ && !frame_.isNull()) {
+			return QRect();
+		}
+		frame_sequence_ = snapshot->get_sequence();
+
+		const QRgb* source = nullptr;
+		Point dimensions(0, 0);
+		if (section_id_ < snapshot->get_num_sections()) {
+			dimensions = snapshot->get_dimensions(section_id_);
+			source = snapshot->get_pixels(section_id_);
+		}
+
+		bool resized = false;
+		if (frame_.width() != dimensions.x || frame_.height() != dimensions.y) {
+			frame_ = QImage(dimensions.x, dimensions.y, QImage::Format_RGB32);
+			layout();
+			resized = true;
+		}
+
+		// Track the bounds of every Pixel that changed
+		int min_x = dimensions.x, min_y = dimensions.y;
+		int max_x = -1, max_y = -1;
+		for (uint16_t row = 0; row < dimensions.y; row++) {
+			QRgb* scanline = reinterpret_cast<QRgb*>(frame_.scanLine(row));
+			for (uint16_t column = 0; column < dimensions.x; column++) {
+				QRgb color = source[dimensions.get_inline_index(column, row)];
+				if (resized || scanline[column] != color) {
+					scanline[column] = color;
+					if (column < min_x) min_x = column;
+					if (column > max_x) max_x = column;
+					if (row < min_y) min_y = row;
+					if (row > max_y) max_y = row;
+				}
+			}
+		}
+
+		if (max_x < 0) {
+			return QRect();
+		}
+
+		QRect changed(QPoint(min_x, min_y), QPoint(max_x, max_y));
+		if (lod_ > 1) {
+			downsample(map_pixels_to_texels(changed));
+		}
+
+		return changed;
+	}
+
+	/**
+	 * Stops drawing the hover border.
+	 * @return Area that needs to be repainted.
+	 */
+	QRegion SectionRenderer::clear_cursor() {
+		QRect last = cursor_rect_;
+		cursor_active_ = false;
+		cursor_rect_ = QRect();
+		return QRegion(last);
+	}
+
+	/**
+	 * Averages blocks of Pixels from the frame buffer into the downsampled view.
+	 * @param texels The texels of the downsampled view to update.
+	 */
+	void SectionRenderer::downsample(const QRect& texels) {
+		for (int row = texels.top(); row <= texels.bottom(); row++) {
+			QRgb* scanline = reinterpret_cast<QRgb*>(lod_frame_.scanLine(row));
+			int top = row * lod_;
+			int bottom = qMin(top + lod_, frame_.height());
+
+			for (int column = texels.left(); column <= texels.right(); column++) {
+				int left = column * lod_;
+				int right = qMin(left + lod_, frame_.width());
+
+				uint32_t red = 0, green = 0, blue = 0;
+				for (int y = top; y < bottom; y++) {
+					const QRgb* source = reinterpret_cast<const QRgb*>(frame_.constScanLine(y));
+					for (int x = left; x < right; x++) {
+						red += qRed(source[x]);
+						green += qGreen(source[x]);
+						blue += qBlue(source[x]);
+					}
+				}
+
+				uint32_t count = (right - left) * (bottom - top);
+				scanline[column] = qRgb(red / count, green / count, blue / count);
+			}
+		}
+	}
+
+	/**
+	 * Draws a light border around the Pixel under the cursor.
+	 * @param painter Painter for the widget.
+	 */
+	void SectionRenderer::draw_cursor(QPainter& painter) {
+		if (cursor_rect_.isEmpty()) return;
+
+		QRect rect = cursor_rect_.adjusted(1, 1, -1, -1);
+		painter.setRenderHint(QPainter::Antialiasing);
+		painter.setBrush(Qt::BrushStyle::NoBrush);
+		painter.setPen(Qt::PenStyle::SolidLine);
+		switch (pixel_shape_) {
+			case 0:	// Circle
+				painter.drawEllipse(rect);
+				break;
+			case 1:	// Rect
+				painter.drawRect(rect);
+				break;
+		}
+	}
+
+	/**
+	 * Draws the Section by scaling the frame buffer onto the widget.
+	 * Circular Pixels are created by tiling a pre-rendered mask over the frame buffer.
+	 * @param painter Painter for the widget.
+	 * @param texels The texels to redraw.
+	 */
+	void SectionRenderer::draw_framebuffer(QPainter& painter, const QRect& texels) {
+		// Scale the frame buffer up to the output size. Smoothing is disabled so that each texel becomes a solid block.
+		QRect target = map_texels_to_rect(texels);
+		painter.drawImage(target, get_view(), texels);
+
+		if (!pixel_mask_.isNull()) {
+			painter.drawTiledPixmap(target, pixel_mask_);
+		}
+
+		// If Canvas is enabled, draw a light border around the Pixel under the cursor
+		draw_cursor(painter);
+	}
+
+	/**
+	 * Draws the Section by painting each Pixel as a separate shape.
+	 * @param painter Painter for the widget.
+	 * @param texels The texels to redraw.
+	 */
+	void SectionRenderer::draw_pixels(QPainter& painter, const QRect& texels) {
+		// Downsampled texels cover several Pixels, so they're always drawn as squares
+		bool circles = (pixel_shape_ == 0 && lod_ == 1);
+		painter.setRenderHint(QPainter::Antialiasing, circles);
+		painter.setPen(Qt::PenStyle::NoPen);
+
+		/*
+		 * Draw each Pixel.
+		 * For each Pixel, translate it's RGB color into a QColor.
+		 * Then, depending on the user's preferenes, draw it as either a circle or a square.
+		 * The position of each Pixel is stepped from the origin and pitch calculated in layout().
+		 */
+		const QImage& view = get_view();
+		QRect rect = map_texels_to_rect(QRect(texels.topLeft(), QSize(1, 1)));
+		int left = rect.x();
+		for (int row = texels.top(); row <= texels.bottom(); row++) {
+			const QRgb* scanline = reinterpret_cast<const QRgb*>(view.constScanLine(row));
+			rect.moveLeft(left);
+			for (int column = texels.left(); column <= texels.right(); column++) {
+				QColor color(scanline[column]);
+
+				if (circles) {
+					painter.setBrush(color);
+					painter.drawEllipse(rect);
+				}
+				else {
+					painter.fillRect(rect, color);
+				}
+
+				rect.translate(radius_, 0);
+			}
+			rect.translate(0, radius_);
+		}
+
+		// If Canvas is enabled, draw a light border around the Pixel under the cursor
+		draw_cursor(painter);
+	}
+
+	/**
+	 * Returns the area of the widget that the Section is drawn in.
+	 * @return Section bounds.
+	 */
+	QRect SectionRenderer::get_bounds() const {
+		return bounds_;
+	}
+
+	/**
+	 * Returns the Section being rendered.
+	 * @return Rendered Section.
+	 */
+	Section& SectionRenderer::get_section() const {
+		return section_;
+	}
+
+	/**
+	 * Returns the image that is drawn to the screen.
+	 * This is the frame buffer, or the downsampled view if each Pixel would be smaller than a screen pixel.
+	 * @return Displayed image.
+	 */
+	const QImage& SectionRenderer::get_view() const {
+		return (lod_ > 1) ? lod_frame_ : frame_;
+	}
+
+	/**
+	 * Recalculates the size of each Pixel and the Section's position within the bounds.
+	 * The point of the Section at the center of the bounds stays in place.
+	 */
+	void SectionRenderer::layout() {
+		layout(bounds_.center(), center_);
+	}
+
+	/**
+	 * Recalculates the size of each Pixel and the Section's position within the bounds.
+	 * At the default zoom level, the entire Section fits within the bounds and is centered.
+	 * When zoomed in, the Section is positioned so that the given point of the Section appears at the anchor, without scrolling past its edges.
+	 * @param anchor Location in the widget.
+	 * @param anchor_pixel Location in the Section, in Pixels, to place at the anchor.
+	 */
+	void SectionRenderer::layout(const QPoint& anchor, const QPointF& anchor_pixel) {
+		QSize dimensions = frame_.size();
+		if (dimensions.isEmpty() || bounds_.isEmpty()) {
+			radius_ = 0;
+			lod_ = 1;
+			lod_frame_ = QImage();
+			pixel_mask_ = QPixmap();
+			update_cursor_rect();
+			return;
+		}
+
+		/*
+		 * Find the largest Pixel size where the entire Section fits within the bounds, then apply the zoom level.
+		 * If Pixels would end up smaller than a screen pixel, draw a downsampled view instead, where each screen pixel averages a block of Pixels.
+		 */
+		qreal fit = qMin(bounds_.width() / static_cast<qreal>(dimensions.width()), bounds_.height() / static_cast<qreal>(dimensions.height()));
+		qreal scale = fit * (1 << zoom_);
+		if (scale >= 1) {
+			radius_ = static_cast<uint16_t>(scale);
+			lod_ = 1;
+			lod_frame_ = QImage();
+		}
+		else {
+			radius_ = 1;
+			lod_ = static_cast<uint16_t>(qCeil(1 / scale));
+			QSize view_size((dimensions.width() + lod_ - 1) / lod_, (dimensions.height() + lod_ - 1) / lod_);
+			if (lod_frame_.size() != view_size) {
+				lod_frame_ = QImage(view_size, QImage::Format_RGB32);
+			}
+			downsample(QRect(QPoint(0, 0), view_size));
+		}
+
+		// Place the anchor Pixel under the anchor, then keep the Section from scrolling past its edges. Sections smaller than the bounds are centered.
+		qreal pitch = static_cast<qreal>(radius_) / lod_;
+		QSize content = get_view().size() * radius_;
+		origin_ = anchor - (anchor_pixel * pitch).toPoint();
+
+		if (content.width() <= bounds_.width()) {
+			origin_.setX(bounds_.x() + (bounds_.width() - content.width()) / 2);
+		}
+		else {
+			origin_.setX(qBound(bounds_.x() + bounds_.width() - content.width(), origin_.x(), bounds_.x()));
+		}
+
+		if (content.height() <= bounds_.height()) {
+			origin_.setY(bounds_.y() + (bounds_.height() - content.height()) / 2);
+		}
+		else {
+			origin_.setY(qBound(bounds_.y() + bounds_.height() - content.height(), origin_.y(), bounds_.y()));
+		}
+
+		center_ = QPointF(bounds_.center() - origin_) / pitch;
+
+		render_pixel_mask();
+		update_cursor_rect();
+	}
+
+	/**
+	 * Translates the mouse cursor to a PixelMaestro Pixel.
+	 * @param cursor Mouse cursor coordinates.
+	 * @return Pixel coordinate.
+	 */
+	Point SectionRenderer::map_cursor_to_pixel(const QPoint& cursor) const {
+		if (radius_ == 0) {
+			return Point(0, 0);
+		}
+
+		const QImage& view = get_view();
+		int x = qBound(0, qFloor((cursor.x() - origin_.x()) / static_cast<qreal>(radius_)), view.width() - 1) * lod_;
+		int y = qBound(0, qFloor((cursor.y() - origin_.y()) / static_cast<qreal>(radius_)), view.height() - 1) * lod_;
+
+		return Point(qMin(x, frame_.width() - 1), qMin(y, frame_.height() - 1));
+	}
+
+	/**
+	 * Translates a range of Pixels into the range of texels that display them.
+	 * @param pixels Pixel range.
+	 * @return Texel range.
+	 */
+	QRect SectionRenderer::map_pixels_to_texels(const QRect& pixels) const {
+		return QRect(QPoint(pixels.left() / lod_, pixels.top() / lod_), QPoint(pixels.right() / lod_, pixels.bottom() / lod_));
+	}
+
+	/**
+	 * Translates an area of the widget into the range of visible texels it covers.
+	 * @param rect Widget coordinates.
+	 * @return Texel range. Empty if the area doesn't cover any visible texels.
+	 */
+	QRect SectionRenderer::map_rect_to_texels(const QRect& rect) const {
+		if (radius_ == 0) return QRect();
+
+		QRect area = map_texels_to_rect(QRect(QPoint(0, 0), get_view().size())).intersected(rect).intersected(bounds_);
+		if (area.isEmpty()) return QRect();
+
+		return QRect(QPoint((area.left() - origin_.x()) / radius_, (area.top() - origin_.y()) / radius_),
+					 QPoint((area.right() - origin_.x()) / radius_, (area.bottom() - origin_.y()) / radius_));
+	}
+
+	/**
+	 * Translates a range of texels into the area they occupy on the widget.
+	 * @param texels Texel range.
+	 * @return Widget coordinates.
+	 */
+	QRect SectionRenderer::map_texels_to_rect(const QRect& texels) const {
+		return QRect(origin_.x() + (texels.x() * radius_),
+					 origin_.y() + (texels.y() * radius_),
+					 texels.width() * radius_,
+					 texels.height() * radius_);
+	}
+
+	/**
+	 * Draws the Pixels covered by the specified area.
+	 * Only Pixels that are visible within the bounds are drawn.
+	 * @param painter Painter for the widget.
+	 * @param area Area of the widget to redraw.
+	 */
+	void SectionRenderer::paint(QPainter& painter, const QRect& area) {
+		// If this is the first paint, capture a frame first.
+		if (frame_.isNull()) {
+			capture_frame();
+		}
+
+		QRect texels = map_rect_to_texels(area);
+		if (texels.isEmpty()) return;
+
+		painter.save();
+		painter.setClipRect(bounds_, Qt::IntersectClip);
+		switch (render_mode_) {
+			case RenderMode::Painter:
+				draw_pixels(painter, texels);
+				break;
+			case RenderMode::Framebuffer:
+				draw_framebuffer(painter, texels);
+				break;
+		}
+		painter.restore();
+	}
+
+	/**
+	 * Scrolls the Section within the bounds. Only has an effect when zoomed in.
+	 * @param delta Distance to move the Section, in screen pixels.
+	 * @return Area that needs to be repainted. Empty if the Section didn't move.
+	 */
+	QRect SectionRenderer::pan(const QPoint& delta) {
+		QPoint last = origin_;
+		layout(bounds_.center() + delta, center_);
+
+		if (origin_ == last) {
+			return QRect();
+		}
+
+		return bounds_;
+	}
+
+	/**
+	 * Checks the Section for changes.
+	 * @return Area of the widget that needs to be repainted. Empty if nothing changed.
+	 */
+	QRect SectionRenderer::refresh() {
+		QSize previous_size = frame_.size();
+		QRect changed = capture_frame();
+
+		if (frame_.size() != previous_size) {
+			return bounds_;
+		}
+
+		QRect area;
+		if (!changed.isEmpty()) {
+			area = map_texels_to_rect(map_pixels_to_texels(changed)).intersected(bounds_);
+		}
+
+		// Pick up a Canvas being added to or removed from the Section under the cursor
+		if (cursor_active_) {
+			QRect last = cursor_rect_;
+			update_cursor_rect();
+			if (last != cursor_rect_) {
+				area = area.united(last).united(cursor_rect_);
+			}
+		}
+
+		return area;
+	}
+
+	/**
+	 * Pre-renders the mask used to draw circular Pixels in Framebuffer mode.
+	 * The mask covers a single Pixel and is filled with the background color, with a transparent circle cut out of the middle.
+	 */
+	void SectionRenderer::render_pixel_mask() {
+		if (render_mode_ != RenderMode::Framebuffer || pixel_shape_ != 0 || radius_ == 0 || lod_ > 1) {
+			pixel_mask_ = QPixmap();
+			return;
+		}
+
+		QImage mask(radius_, radius_, QImage::Format_ARGB32_Premultiplied);
+		mask.fill(background_);
+
+		QPainter painter(&mask);
+		painter.setRenderHint(QPainter::Antialiasing);
+		painter.setCompositionMode(QPainter::CompositionMode_DestinationOut);
+		painter.setPen(Qt::PenStyle::NoPen);
+		painter.setBrush(Qt::GlobalColor::black);
+		painter.drawEllipse(QRect(0, 0, radius_, radius_));
+		painter.end();
+
+		pixel_mask_ = QPixmap::fromImage(mask);
+	}
+
+	/**
+	 * Zooms or pans the Section using the mouse wheel.
+	 * Ctrl + scroll zooms in and out around the cursor. Scrolling pans vertically, and Shift + scroll pans horizontally.
+	 * @param event Wheel event.
+	 * @return Area that needs to be repainted. Empty if the view didn't change.
+	 */
+	QRect SectionRenderer::scroll(const QWheelEvent& event) {
+		QPoint delta = event.angleDelta();
+		if (delta.isNull()) {
+			return QRect();
+		}
+
+		if (event.modifiers() & Qt::ControlModifier) {
+			return zoom(delta.y() > 0 ? 1 : -1, event.pos());
+		}
+
+		// One notch of the wheel scrolls by 30 screen pixels
+		delta /= 4;
+		if (event.modifiers() & Qt::ShiftModifier) {
+			delta = QPoint(delta.y(), delta.x());
+		}
+
+		return pan(delta);
+	}
+
+	/**
+	 * Sets the area of the widget that the Section is drawn in.
+	 * @param bounds Section bounds.
+	 * @param background The color behind the Section.
+	 */
+	void SectionRenderer::set_bounds(const QRect& bounds, const QColor& background) {
+		this->bounds_ = bounds;
+		this->background_ = background;
+		layout();
+	}
+
+	/**
+	 * Updates the location of the mouse cursor.
+	 * @param cursor Mouse cursor coordinates.
+	 * @return Area that needs to be repainted to move the hover border.
+	 */
+	QRegion SectionRenderer::set_cursor(const QPoint& cursor) {
+		QRect last = cursor_rect_;
+		cursor_pos_ = cursor;
+		cursor_active_ = true;
+		update_cursor_rect();
+
+		if (last == cursor_rect_) {
+			return QRegion();
+		}
+
+		return QRegion(last).united(cursor_rect_);
+	}
+
+	/**
+	 * Recalculates the area covered by the hover border.
+	 * The border is only drawn while the cursor is over a Section with a Canvas.
+	 */
+	void SectionRenderer::update_cursor_rect() {
+		bool has_canvas;
+		{
+			QMutexLocker locker(maestro_controller_.get_maestro_mutex());
+			has_canvas = (section_.get_canvas() != nullptr);
+		}
+
+		if (!cursor_active_ || radius_ == 0 || !has_canvas) {
+			cursor_rect_ = QRect();
+			return;
+		}
+
+		Point pixel = map_cursor_to_pixel(cursor_pos_);
+		cursor_rect_ = map_texels_to_rect(QRect(pixel.x / lod_, pixel.y / lod_, 1, 1)).adjusted(-1, -1, 1, 1);
+	}
+
+	/**
+	 * Zooms in or out on the Section.
+	 * Zooming out stops once the entire Section fits within the bounds.
+	 * @param steps Number of zoom levels to change by. Each level doubles or halves the size of each Pixel.
+	 * @param anchor Location in the widget that stays in place while zooming, usually the mouse cursor.
+	 * @return Area that needs to be repainted. Empty if the zoom level didn't change.
+	 */
+	QRect SectionRenderer::zoom(int steps, const QPoint& anchor) {
+		int zoom = qBound(0, zoom_ + steps, MAX_ZOOM);
+		if (zoom == zoom_ || radius_ == 0) {
+			return QRect();
+		}
+
+		// Keep the Pixel under the anchor in place
+		qreal pitch = static_cast<qreal>(radius_) / lod_;
+		QPointF anchor_pixel = QPointF(anchor - origin_) / pitch;
+
+		zoom_ = zoom;
+		layout(anchor, anchor_pixel);
+
+		return bounds_;
+	}
+}
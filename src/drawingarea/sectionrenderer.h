@@ -0,0 +1,126 @@
+/*
+ * SectionRenderer - Draws a single Section's output onto an area of a widget.
+ */
+
+#ifndef SECTIONRENDERER_H
+#define SECTIONRENDERER_H
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QPixmap>
+#include <QPoint>
+#include <QPointF>
+#include <QRect>
+#include <QRegion>
+#include <QWheelEvent>
+#include "core/point.h"
+#include "core/section.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class MaestroController;
+
+	class SectionRenderer {
+		public:
+			/// How Pixels are drawn to the screen.
+			enum class RenderMode : uint8_t {
+				/// Draws each Pixel as a separate shape.
+				Painter,
+
+				/// Writes each Pixel into an image and draws it in a single scaled blit.
+				Framebuffer
+			};
+
+			SectionRenderer(MaestroController& maestro_controller, Section& section, uint8_t section_id);
+			QRegion clear_cursor();
+			QRect get_bounds() const;
+			Section& get_section() const;
+			Point map_cursor_to_pixel(const QPoint& cursor) const;
+			void paint(QPainter& painter, const QRect& area);
+			QRect pan(const QPoint& delta);
+			QRect refresh();
+			QRect scroll(const QWheelEvent& event);
+			void set_bounds(const QRect& bounds, const QColor& background);
+			QRegion set_cursor(const QPoint& cursor);
+			QRect zoom(int steps, const QPoint& anchor);
+
+		private:
+			/// The maximum number of times the Section can be zoomed in. Each level doubles the size of each Pixel.
+			static const int MAX_ZOOM = 8;
+
+			/// The background color behind the Section. Used to render the Pixel mask.
+			QColor background_;
+
+			/// The area of the widget that the Section is drawn in.
+			QRect bounds_;
+
+			/// The location in the Section, in Pixels, shown at the center of the bounds.
+			QPointF center_;
+
+			/// The last location of the mouse cursor.
+			QPoint cursor_pos_;
+
+			/// Whether the mouse cursor is over the Section.
+			bool cursor_active_ = false;
+
+			/// The area covered by the hover border. Recalculated when the cursor moves or the layout changes.
+			QRect cursor_rect_;
+
+			/// The last frame presented, with one texel per Pixel. Used to determine which Pixels changed between refreshes.
+			QImage frame_;
+
+			/// Sequence number of the shared frame that frame_ was copied from.
+			uint32_t frame_sequence_ = 0;
+
+			/// The number of Pixels along each side of a texel. Greater than 1 when the Section is too large to draw one Pixel per screen pixel.
+			uint16_t lod_ = 1;
+
+			/// Downsampled copy of frame_, with one texel for each block of lod_ x lod_ Pixels. Only used when lod_ is greater than 1.
+			QImage lod_frame_;
+
+			/// The controller managing the Section. Provides the shared frame that the Section is copied from.
+			MaestroController& maestro_controller_;
+
+			/// The location where the Section's first Pixel is drawn. Lies outside of the bounds when zoomed in.
+			QPoint origin_;
+
+			/// Pre-rendered overlay that masks a Pixel into a circle. Only used in Framebuffer mode.
+			QPixmap pixel_mask_;
+
+			/// The shape that each Pixel is drawn in. Defaults to square.
+			int pixel_shape_ = 1;
+
+			/// The size of each rendered texel.
+			uint16_t radius_ = 20;
+
+			/// The method used to draw Pixels. Defaults to Framebuffer.
+			RenderMode render_mode_ = RenderMode::Framebuffer;
+
+			/// The Section being rendered.
+			Section& section_;
+
+			/// The Section's index in the Maestro.
+			uint8_t section_id_ = 0;
+
+			/// The current zoom level. 0 fits the entire Section within the bounds.
+			int zoom_ = 0;
+
+			QRect capture_frame();
+			void downsample(const QRect& texels);
+			void draw_cursor(QPainter& painter);
+			void draw_framebuffer(QPainter& painter, const QRect& texels);
+			void draw_pixels(QPainter& painter, const QRect& texels);
+			const QImage& get_view() const;
+			void layout();
+			void layout(const QPoint& anchor, const QPointF& anchor_pixel);
+			QRect map_pixels_to_texels(const QRect& pixels) const;
+			QRect map_rect_to_texels(const QRect& rect) const;
+			QRect map_texels_to_rect(const QRect& texels) const;
+			void render_pixel_mask();
+			void update_cursor_rect();
+	};
+}
+
+#endif // SECTIONRENDERER_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui widgets serialport network
+QT       += core gui widgets serialport network concurrent
 
 TARGET = PixelMaestro_Studio
 TEMPLATE = app
@@ -21,8 +21,16 @@ QMAKE_CXXFLAGS_RELEASE += -O3
 
 
 SOURCES += main.cpp\
+controller/cuefilecache.cpp \
 controller/devicecontroller.cpp \
 controller/devicethreadcontroller.cpp \
+controller/idlescheduler.cpp \
+controller/maestroframe.cpp \
+controller/metricsserver.cpp \
+controller/sectioncompositor.cpp \
+controller/sectionupdater.cpp \
+controller/simulationthreadcontroller.cpp \
+controller/timesource.cpp \
 drawingarea/maestrodrawingarea.cpp \
 controller/maestrocontroller.cpp \
 ../lib/PixelMaestro/src/canvas/fonts/font5x8.cpp \
@@ -60,24 +68,30 @@ controller/showcontroller.cpp \
 utility/canvasutility.cpp \
 ../lib/PixelMaestro/src/cue/showcuehandler.cpp \
 widget/maestrocontrolwidget.cpp \
+widget/performanceoverlay.cpp \
 widget/palettecontrolwidget.cpp \
 widget/animation/lightninganimationcontrolwidget.cpp \
 widget/animation/plasmaanimationcontrolwidget.cpp \
 widget/animation/radialanimationcontrolwidget.cpp \
 widget/animation/sparkleanimationcontrolwidget.cpp \
 dialog/preferencesdialog.cpp \
+dialog/preferencessettings.cpp \
 ../lib/PixelMaestro/src/animation/fireanimation.cpp \
 widget/animation/fireanimationcontrolwidget.cpp \
 ../lib/PixelMaestro/src/core/timer/timer.cpp \
 ../lib/PixelMaestro/src/core/timer/animationtimer.cpp \
 widget/animation/waveanimationcontrolwidget.cpp \
 drawingarea/sectiondrawingarea.cpp \
+drawingarea/sectionrenderer.cpp \
 dialog/maestrodrawingareadialog.cpp \
 ../lib/PixelMaestro/src/core/palette.cpp \
 widget/devicecontrolwidget.cpp \
 dialog/cueinterpreterdialog.cpp \
 dialog/paletteeditdialog.cpp \
 utility/cueinterpreter.cpp \
+utility/cuefileencoder.cpp \
+utility/performancemonitor.cpp \
+utility/tracerecorder.cpp \
 widget/animationcontrolwidget.cpp \
 widget/showcontrolwidget.cpp \
 widget/sectioncontrolwidget.cpp \
@@ -89,8 +103,21 @@ model/cuemodel.cpp \
 dialog/adddevicedialog.cpp
 
 HEADERS += \
+controller/cuefilecache.h \
 controller/devicecontroller.h \
 controller/devicethreadcontroller.h \
+controller/idlescheduler.h \
+controller/maestroframe.h \
+controller/metricsserver.h \
+controller/sectioncompositor.h \
+controller/sectionupdater.h \
+controller/simulationthreadcontroller.h \
+controller/timesource.h \
+utility/cuefileencoder.h \
+utility/cuefileutility.h \
+utility/performancemonitor.h \
+utility/tracerecorder.h \
+utility/triplebuffer.h \
 drawingarea/maestrodrawingarea.h \
 controller/maestrocontroller.h \
 ../lib/PixelMaestro/src/canvas/fonts/font.h \
@@ -130,6 +157,7 @@ controller/showcontroller.h \
 utility/canvasutility.h \
 ../lib/PixelMaestro/src/cue/showcuehandler.h \
 widget/maestrocontrolwidget.h \
+widget/performanceoverlay.h \
 widget/palettecontrolwidget.h \
 widget/animation/lightninganimationcontrolwidget.h \
 widget/animation/plasmaanimationcontrolwidget.h \
@@ -142,6 +170,7 @@ widget/animation/fireanimationcontrolwidget.h \
 ../lib/PixelMaestro/src/core/timer/animationtimer.h \
 widget/animation/waveanimationcontrolwidget.h \
 drawingarea/sectiondrawingarea.h \
+drawingarea/sectionrenderer.h \
 dialog/maestrodrawingareadialog.h \
 ../lib/PixelMaestro/src/core/palette.h \
 widget/devicecontrolwidget.h \
@@ -0,0 +1,282 @@
+#include "animation/fireanimation.h"
+#include "animation/lightninganimation.h"
+#include "animation/plasmaanimation.h"
+#include "animation/radialanimation.h"
+#include "animation/sparkleanimation.h"
+#include "animation/waveanimation.h"
+#include "canvas/canvas.h"
+#include "cue/animationcuehandler.h"
+#include "cue/canvascuehandler.h"
+#include "cue/maestrocuehandler.h"
+#include "cue/sectioncuehandler.h"
+#include "cue/show.h"
+#include "cue/showcuehandler.h"
+#include "cuefileencoder.h"
+#include "cuefileutility.h"
+#include <QByteArray>
+#include <QtConcurrent/QtConcurrentMap>
+
+namespace PixelMaestroStudio {
+	/**
+	 * Encodes several Sections, in parallel if there's more than one.
+	 * Cues are built in the CueController's buffer, so each thread gets its own CueController. A single Section is encoded on the calling thread using the given CueController.
+	 * @param controller CueController used when there's only one Section to encode.
+	 * @param sections Indices of the Sections to encode.
+	 * @param encode Encodes a single Section using the given CueController. Must only write to storage belonging to that Section.
+	 */
+	void CuefileEncoder::encode_sections(CueController& controller, std::vector<uint8_t>& sections, const std::function<void(CueController& controller, uint8_t section)>& encode) {
+		if (sections.empty()) return;
+
+		if (sections.size() == 1) {
+			encode(controller, sections.front());
+			return;
+		}
+
+		// Sections don't depend on each other, so encode them in parallel
+		QtConcurrent::blockingMap(sections, [&encode](uint8_t section) {
+			Maestro virtual_maestro(nullptr, 0);
+			encode(CuefileUtility::initialize_cue_controller(virtual_maestro), section);
+		});
+	}
+
+	/**
+	 * Saves a single Layer's settings to a DataStream as Cues, ending with the Cue that creates the next Layer (if any).
+	 * @param datastream Stream to save Cues to.
+	 * @param maestro Maestro to save.
+	 * @param controller CueController used to build the Cues. Threads encoding at the same time each need their own, since Cues are built in the controller's buffer.
+	 * @param section_id The index of the Section to save.
+	 * @param layer_id The index of the Layer to save.
+	 * @param save_handlers CueHandlers that are enabled for saving. If null, save all Cues
+	 * @return True if the Layer has another Layer above it.
+	 */
+	bool CuefileEncoder::save_layer(QDataStream& datastream, Maestro& maestro, CueController& controller, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers) {
+
+		Section* section = maestro.get_section(section_id);
+		if (section == nullptr) return false;
+
+		if (layer_id > 0) {
+			for (uint8_t i = 0; i < layer_id; i++) {
+				section = section->get_layer()->section;
+			}
+		}
+
+		SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+
+		// Global Section settings
+		if (section->get_brightness() != 255) {
+			write_cue(datastream, controller, section_handler->set_brightness(section_id, layer_id, section->get_brightness()));
+		}
+
+		// Only set dimensions for Sections, not Layers
+		if (layer_id == 0) {
+			write_cue(datastream, controller, section_handler->set_dimensions(section_id, layer_id, section->get_dimensions().x, section->get_dimensions().y));
+		}
+
+		// Animation & Colors
+		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::AnimationCueHandler)) {
+			Animation* animation = section->get_animation();
+			if (animation != nullptr) {
+				write_cue(datastream, controller, section_handler->set_animation(section_id, layer_id, animation->get_type()));
+
+				AnimationCueHandler* animation_handler = dynamic_cast<AnimationCueHandler*>(controller.get_handler(CueController::Handler::AnimationCueHandler));
+				if (animation->get_palette() != nullptr) {
+					write_cue(datastream, controller, animation_handler->set_palette(section_id, layer_id, *animation->get_palette()));
+				}
+				write_cue(datastream, controller, animation_handler->set_center(section_id, layer_id, animation->get_center().x, animation->get_center().y));
+				write_cue(datastream, controller, animation_handler->set_orientation(section_id, layer_id, animation->get_orientation()));
+				write_cue(datastream, controller, animation_handler->set_reverse(section_id, layer_id, animation->get_reverse()));
+				write_cue(datastream, controller, animation_handler->set_fade(section_id, layer_id, animation->get_fade()));
+
+				if (animation->get_timer() != nullptr) {
+					write_cue(datastream, controller, animation_handler->set_timer(section_id, layer_id, animation->get_timer()->get_interval(), animation->get_timer()->get_delay()));
+				}
+
+				// Save Animation-specific settings
+				switch(animation->get_type()) {
+					case AnimationType::Fire:
+						{
+							FireAnimation* fa = dynamic_cast<FireAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_fire_options(section_id, layer_id, fa->get_multiplier()));
+						}
+						break;
+					case AnimationType::Lightning:
+						{
+							LightningAnimation* la = dynamic_cast<LightningAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_lightning_options(section_id, layer_id, la->get_bolt_count(), la->get_drift(), la->get_fork_chance()));
+						}
+						break;
+					case AnimationType::Plasma:
+						{
+							PlasmaAnimation* pa = dynamic_cast<PlasmaAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_plasma_options(section_id, layer_id, pa->get_size(), pa->get_resolution()));
+						}
+						break;
+					case AnimationType::Radial:
+						{
+							RadialAnimation* ra = dynamic_cast<RadialAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_radial_options(section_id, layer_id, ra->get_resolution()));
+						}
+						break;
+					case AnimationType::Sparkle:
+						{
+							SparkleAnimation* sa = dynamic_cast<SparkleAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_sparkle_options(section_id, layer_id, sa->get_threshold()));
+						}
+						break;
+					case AnimationType::Wave:
+						{
+							WaveAnimation* wa = dynamic_cast<WaveAnimation*>(animation);
+							write_cue(datastream, controller, animation_handler->set_wave_options(section_id, layer_id, wa->get_skew()));
+						}
+						break;
+					default:
+						break;
+				}
+			}
+		}
+
+		// Scrolling, offset, mirroring, wrap
+		Point& offset = section->get_offset();
+		if (offset.x != 0 || offset.y != 0) {
+			write_cue(datastream, controller, section_handler->set_offset(section_id, layer_id, offset.x, offset.y));
+		}
+		Section::Scroll* scroll = section->get_scroll();
+		if (scroll != nullptr) {
+			write_cue(datastream, controller, section_handler->set_scroll(section_id, layer_id, scroll->interval_x, scroll->interval_y, scroll->reverse_x, scroll->reverse_y));
+		}
+		Section::Mirror* mirror = section->get_mirror();
+		if (mirror != nullptr) {
+			write_cue(datastream, controller, section_handler->set_mirror(section_id, layer_id, mirror->x, mirror->y));
+		}
+		bool wrap = section->get_wrap();
+		if (wrap == false) {
+			write_cue(datastream, controller, section_handler->set_wrap(section_id, layer_id, wrap));
+		}
+
+		// Save Canvas settings
+		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::CanvasCueHandler)) {
+			Canvas* canvas = section->get_canvas();
+			if (canvas != nullptr) {
+				write_cue(datastream, controller, section_handler->set_canvas(section_id, layer_id, canvas->get_num_frames()));
+
+				CanvasCueHandler* canvas_handler = dynamic_cast<CanvasCueHandler*>(controller.get_handler(CueController::Handler::CanvasCueHandler));
+
+				if (canvas->get_frame_timer()) {
+					write_cue(datastream, controller, canvas_handler->set_frame_timer(section_id, layer_id, canvas->get_frame_timer()->get_interval()));
+				}
+
+				if (canvas->get_palette() != nullptr) {
+					write_cue(datastream, controller, canvas_handler->set_palette(section_id, layer_id, *canvas->get_palette()));
+				}
+
+				// Draw and save each frame
+				for (uint16_t frame = 0; frame < canvas->get_num_frames(); frame++) {
+					write_cue(datastream, controller, canvas_handler->draw_frame(section_id, layer_id, frame, section->get_dimensions().x, section->get_dimensions().y, canvas->get_frame(frame)));
+				}
+				write_cue(datastream, controller, canvas_handler->set_current_frame_index(section_id, layer_id, canvas->get_current_frame_index()));
+			}
+		}
+
+		// Layers
+		Section::Layer* layer = section->get_layer();
+		if (layer != nullptr) {
+			write_cue(datastream, controller, section_handler->set_layer(section_id, layer_id, layer->mix_mode, layer->alpha));
+			return true;
+		}
+
+		return false;
+	}
+
+	/**
+	 * Saves the entire Maestro to a DataStream as Cues.
+	 * @param datastream Stream to save Cues to.
+	 * @param maestro Maestro to save.
+	 * @param default_interval The refresh interval that new Maestros start with. The Maestro's timer is only saved if it differs.
+	 * @param save_handlers CueHandlers that are enabled for saving. If null, save all Cues
+	 */
+	void CuefileEncoder::save_maestro(QDataStream& datastream, Maestro& maestro, uint16_t default_interval, QVector<CueController::Handler>* save_handlers) {
+		save_maestro_settings(datastream, maestro, maestro.get_cue_controller(), default_interval, save_handlers);
+
+		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::SectionCueHandler)) {
+			// Encode each Section into its own buffer, then write them out in order
+			uint8_t num_sections = maestro.get_num_sections();
+			std::vector<QByteArray> sections(num_sections);
+			std::vector<uint8_t> section_ids(num_sections);
+			for (uint8_t section = 0; section < num_sections; section++) {
+				section_ids[section] = section;
+			}
+			encode_sections(maestro.get_cue_controller(), section_ids, [&](CueController& controller, uint8_t section) {
+				QDataStream section_datastream(&sections[section], QIODevice::WriteOnly);
+				save_section(section_datastream, maestro, controller, section, 0, save_handlers);
+			});
+
+			for (const QByteArray& section : sections) {
+				datastream.writeRawData(section.constData(), section.size());
+			}
+		}
+	}
+
+	/**
+	 * Saves the Maestro's own settings and its Show to a DataStream as Cues, without any Sections.
+	 * @param datastream Stream to save Cues to.
+	 * @param maestro Maestro to save.
+	 * @param controller CueController used to build the Cues.
+	 * @param default_interval The refresh interval that new Maestros start with. The Maestro's timer is only saved if it differs.
+	 * @param save_handlers CueHandlers that are enabled for saving.
+	 */
+	void CuefileEncoder::save_maestro_settings(QDataStream& datastream, Maestro& maestro, CueController& controller, uint16_t default_interval, QVector<CueController::Handler>* save_handlers) {
+		MaestroCueHandler* maestro_handler = dynamic_cast<MaestroCueHandler*>(controller.get_handler(CueController::Handler::MaestroCueHandler));
+
+		// Maestro-specific Cues
+		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::MaestroCueHandler)) {
+			if (maestro.get_timer().get_interval() != default_interval) {
+				write_cue(datastream, controller, maestro_handler->set_timer(default_interval));
+			}
+		}
+
+		// Show-specific Cues
+		if (save_handlers == nullptr || save_handlers->contains(CueController::Handler::ShowCueHandler)) {
+			Show* show = maestro.get_show();
+			if (show != nullptr) {
+				write_cue(datastream, controller, maestro_handler->set_show());
+
+				ShowCueHandler* show_handler = dynamic_cast<ShowCueHandler*>(controller.get_handler(CueController::Handler::ShowCueHandler));
+				write_cue(datastream, controller, show_handler->set_looping(show->get_looping()));
+				write_cue(datastream, controller, show_handler->set_timing_mode(show->get_timing()));
+
+				// Save events for last until I can nail down the byte alignment issues with event Cues
+				if (show->get_events() != nullptr) {
+					write_cue(datastream, controller, show_handler->set_events(show->get_events(), show->get_num_events(), false));
+				}
+			}
+		}
+	}
+
+	/**
+	 * Saves a Section and every Layer above the given one to a DataStream as Cues.
+	 * @param datastream Stream to save Cues to.
+	 * @param maestro Maestro to save.
+	 * @param controller CueController used to build the Cues.
+	 * @param section_id The index of the Section to save.
+	 * @param layer_id The index of the first Layer to save.
+	 * @param save_handlers CueHandlers that are enabled for saving. If null, save all Cues
+	 */
+	void CuefileEncoder::save_section(QDataStream& datastream, Maestro& maestro, CueController& controller, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers) {
+		while (save_layer(datastream, maestro, controller, section_id, layer_id, save_handlers)) {
+			layer_id++;
+		}
+	}
+
+	/**
+	 * Appends a Cue to a stream.
+	 * @param stream Stream to append to.
+	 * @param controller CueController that built the Cue.
+	 * @param cue Cue to append.
+	 */
+	void CuefileEncoder::write_cue(QDataStream& stream, CueController& controller, uint8_t* cue) {
+		if (cue != nullptr) {
+			uint32_t size = controller.get_cue_size(cue);
+			stream.writeRawData((const char*)cue, (int)size);
+		}
+	}
+}
@@ -0,0 +1,31 @@
+/*
+ * CuefileEncoder - Saves a Maestro's configuration as Cues.
+ * Only reads the Maestro, so it doesn't depend on any widgets. Callers are responsible for locking the Maestro while it's being saved.
+ */
+
+#ifndef CUEFILEENCODER_H
+#define CUEFILEENCODER_H
+
+#include <QDataStream>
+#include <QVector>
+#include <functional>
+#include <stdint.h>
+#include <vector>
+#include "core/maestro.h"
+#include "cue/cuecontroller.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class CuefileEncoder {
+		public:
+			static void encode_sections(CueController& controller, std::vector<uint8_t>& sections, const std::function<void(CueController& controller, uint8_t section)>& encode);
+			static bool save_layer(QDataStream& datastream, Maestro& maestro, CueController& controller, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers = nullptr);
+			static void save_maestro(QDataStream& datastream, Maestro& maestro, uint16_t default_interval, QVector<CueController::Handler>* save_handlers = nullptr);
+			static void save_maestro_settings(QDataStream& datastream, Maestro& maestro, CueController& controller, uint16_t default_interval, QVector<CueController::Handler>* save_handlers = nullptr);
+			static void save_section(QDataStream& datastream, Maestro& maestro, CueController& controller, uint8_t section_id, uint8_t layer_id, QVector<CueController::Handler>* save_handlers = nullptr);
+			static void write_cue(QDataStream& stream, CueController& controller, uint8_t* cue);
+	};
+}
+
+#endif // CUEFILEENCODER_H
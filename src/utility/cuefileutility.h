@@ -0,0 +1,57 @@
+/*
+ * CuefileUtility - Tools for loading Cuefiles into a Maestro.
+ * Shared between PixelMaestro Studio and the headless runner, so it must not depend on any widgets.
+ */
+
+#ifndef CUEFILEUTILITY_H
+#define CUEFILEUTILITY_H
+
+#include <QByteArray>
+#include "core/maestro.h"
+#include "cue/cuecontroller.h"
+
+using namespace PixelMaestro;
+
+namespace PixelMaestroStudio {
+	class CuefileUtility {
+		public:
+			/**
+			 * Enables the Maestro's CueController along with every CueHandler that Studio supports.
+			 * @param maestro Maestro to configure.
+			 * @return The Maestro's CueController.
+			 */
+			static CueController& initialize_cue_controller(Maestro& maestro) {
+				CueController& controller = maestro.set_cue_controller(UINT16_MAX);
+				controller.enable_animation_cue_handler();
+				controller.enable_canvas_cue_handler();
+				controller.enable_maestro_cue_handler();
+				controller.enable_section_cue_handler();
+				controller.enable_show_cue_handler();
+				return controller;
+			}
+
+			/**
+			 * Splits a Cuefile into individual Cues.
+			 * Each byte is read into a virtual Maestro, and each Cue it accepts is passed to the callback. Invalid Cues are skipped.
+			 * @param bytes Contents of the Cuefile.
+			 * @param run_cue Called with each Cue. The Cue is only valid until the callback returns.
+			 * @return The number of Cues read.
+			 */
+			template<typename Callback>
+			static uint32_t read_cuefile(const QByteArray& bytes, Callback run_cue) {
+				Maestro virtual_maestro(nullptr, 0);
+				CueController& controller = virtual_maestro.set_cue_controller(UINT16_MAX);
+
+				uint32_t num_cues = 0;
+				for (char byte_char : bytes) {
+					if (controller.read(static_cast<uint8_t>(byte_char))) {
+						run_cue(controller.get_buffer());
+						num_cues++;
+					}
+				}
+				return num_cues;
+			}
+	};
+}
+
+#endif // CUEFILEUTILITY_H
@@ -0,0 +1,149 @@
+#include <algorithm>
+#include <QtGlobal>
+#include "performancemonitor.h"
+
+namespace PixelMaestroStudio {
+	// Static storage is zero-initialized, so every counter, gauge, and sample starts at 0
+	std::atomic<uint64_t> PerformanceMonitor::counters_[static_cast<uint8_t>(Counter::NumCounters)];
+	std::atomic<bool> PerformanceMonitor::enabled_(false);
+	std::atomic<uint64_t> PerformanceMonitor::gauges_[static_cast<uint8_t>(Gauge::NumGauges)];
+	PerformanceMonitor::StageSamples PerformanceMonitor::stages_[static_cast<uint8_t>(Stage::NumStages)];
+
+	const uint32_t PerformanceMonitor::NUM_SAMPLES;
+
+	/**
+	 * Starts timing a Stage.
+	 * Nothing is recorded if the monitor is disabled.
+	 * @param stage Stage to time.
+	 */
+	PerformanceMonitor::Scope::Scope(Stage stage) : active_(PerformanceMonitor::get_enabled()), stage_(stage) {
+		if (active_) {
+			timer_.start();
+		}
+	}
+
+	/**
+	 * Records the Stage's duration.
+	 */
+	PerformanceMonitor::Scope::~Scope() {
+		if (active_) {
+			PerformanceMonitor::add_sample(stage_, timer_.nsecsElapsed());
+		}
+	}
+
+	/**
+	 * Records how long a Stage took.
+	 * Samples from different threads may interleave, but never block each other.
+	 * @param stage Stage that was timed.
+	 * @param nsecs Duration in nanoseconds.
+	 */
+	void PerformanceMonitor::add_sample(Stage stage, qint64 nsecs) {
+		StageSamples& samples = stages_[static_cast<uint8_t>(stage)];
+		uint32_t index = samples.count.fetch_add(1, std::memory_order_relaxed) % NUM_SAMPLES;
+		samples.samples[index].store(static_cast<uint32_t>(qBound<qint64>(0, nsecs, UINT32_MAX)), std::memory_order_relaxed);
+	}
+
+	/**
+	 * Returns the current value of a counter.
+	 * @param counter Counter to read.
+	 * @return Counter value.
+	 */
+	uint64_t PerformanceMonitor::get_count(Counter counter) {
+		return counters_[static_cast<uint8_t>(counter)].load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Returns whether Stages are being timed.
+	 * @return True if enabled.
+	 */
+	bool PerformanceMonitor::get_enabled() {
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Summarizes a Stage's recent samples.
+	 * @param stage Stage to summarize.
+	 * @return Average and 99th percentile of the most recent samples.
+	 */
+	PerformanceMonitor::StageStats PerformanceMonitor::get_stats(Stage stage) {
+		StageSamples& samples = stages_[static_cast<uint8_t>(stage)];
+
+		StageStats stats;
+		stats.num_samples = qMin(samples.count.load(std::memory_order_relaxed), NUM_SAMPLES);
+		if (stats.num_samples == 0) return stats;
+
+		// Copy the samples so that recording can continue while they're sorted
+		uint32_t copy[NUM_SAMPLES];
+		double total = 0;
+		for (uint32_t i = 0; i < stats.num_samples; i++) {
+			copy[i] = samples.samples[i].load(std::memory_order_relaxed);
+			total += copy[i];
+		}
+
+		uint32_t p99_index = (stats.num_samples * 99 + 99) / 100 - 1;
+		std::nth_element(copy, copy + p99_index, copy + stats.num_samples);
+
+		stats.average = total / stats.num_samples / 1000.0;
+		stats.p99 = copy[p99_index] / 1000.0;
+		return stats;
+	}
+
+	/**
+	 * Returns the display name of a Stage.
+	 * @param stage Stage.
+	 * @return Stage name.
+	 */
+	const char* PerformanceMonitor::get_stage_name(Stage stage) {
+		switch (stage) {
+			case Stage::Update:
+				return "Update";
+			case Stage::Paint:
+				return "Paint";
+			case Stage::RunCue:
+				return "Run Cue";
+			case Stage::CuefileLoad:
+				return "Load";
+			case Stage::DeviceWrite:
+				return "Device write";
+			case Stage::CuefileGeneration:
+				return "Cuefile";
+			default:
+				return "";
+		}
+	}
+
+	/**
+	 * Returns the current value of a Gauge.
+	 * @param gauge Gauge to read.
+	 * @return Gauge value.
+	 */
+	uint64_t PerformanceMonitor::get_value(Gauge gauge) {
+		return gauges_[static_cast<uint8_t>(gauge)].load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Increments a counter.
+	 * @param counter Counter to increment.
+	 * @param amount Amount to add.
+	 */
+	void PerformanceMonitor::increment(Counter counter, uint64_t amount) {
+		counters_[static_cast<uint8_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Turns Stage timing on or off.
+	 * @param enabled If true, Stages are timed.
+	 */
+	void PerformanceMonitor::set_enabled(bool enabled) {
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Sets the value of a Gauge.
+	 * @param gauge Gauge to set.
+	 * @param value New value.
+	 */
+	void PerformanceMonitor::set_value(Gauge gauge, uint64_t value) {
+		gauges_[static_cast<uint8_t>(gauge)].store(value, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,133 @@
+/*
+ * PerformanceMonitor - Collects timings and counters from Studio's hot paths.
+ * Recording is lock-free so that it can be left on during a live show, and can be called from any thread.
+ */
+
+#ifndef PERFORMANCEMONITOR_H
+#define PERFORMANCEMONITOR_H
+
+#include <QElapsedTimer>
+#include <atomic>
+#include <stdint.h>
+
+namespace PixelMaestroStudio {
+	class PerformanceMonitor {
+		public:
+			/// Timed stages of the render loop.
+			enum class Stage : uint8_t {
+				/// Maestro::update().
+				Update,
+
+				/// Redrawing a DrawingArea.
+				Paint,
+
+				/// Running a Cue from the UI.
+				RunCue,
+
+				/// Loading a Cuefile into the Maestro.
+				CuefileLoad,
+
+				/// Writing to a device.
+				DeviceWrite,
+
+				/// Regenerating the Cuefile shown in the Device tab.
+				CuefileGeneration,
+
+				/// The number of Stages. Not a Stage.
+				NumStages
+			};
+
+			/// Event counters.
+			enum class Counter : uint8_t {
+				/// Maestro updates.
+				FramesSimulated,
+
+				/// Frames drawn to the screen.
+				FramesPresented,
+
+				/// Maestro updates that ran late enough to skip at least one refresh interval.
+				MissedTicks,
+
+				/// Cues run on the Maestro.
+				CuesRun,
+
+				/// The number of Counters. Not a Counter.
+				NumCounters
+			};
+
+			/// Values that are replaced rather than accumulated.
+			enum class Gauge : uint8_t {
+				/// Size in bytes of the Cuefile most recently generated in the Device tab.
+				CuefileSize,
+
+				/// The number of Gauges. Not a Gauge.
+				NumGauges
+			};
+
+			/// Summary of a Stage's recent timings.
+			struct StageStats {
+				/// Average duration in microseconds.
+				double average = 0;
+
+				/// 99th percentile duration in microseconds.
+				double p99 = 0;
+
+				/// The number of samples that the stats were calculated from.
+				uint32_t num_samples = 0;
+			};
+
+			/// Times a Stage from construction until destruction.
+			class Scope {
+				public:
+					explicit Scope(Stage stage);
+					~Scope();
+
+				private:
+					/// Whether the monitor was enabled when the Scope started.
+					bool active_;
+
+					/// The Stage being timed.
+					Stage stage_;
+
+					/// Measures the Stage's duration.
+					QElapsedTimer timer_;
+			};
+
+			/// The number of recent samples kept for each Stage.
+			static const uint32_t NUM_SAMPLES = 128;
+
+			static void add_sample(Stage stage, qint64 nsecs);
+			static uint64_t get_count(Counter counter);
+			static bool get_enabled();
+			static StageStats get_stats(Stage stage);
+			static const char* get_stage_name(Stage stage);
+			static uint64_t get_value(Gauge gauge);
+			static void increment(Counter counter, uint64_t amount = 1);
+			static void set_enabled(bool enabled);
+			static void set_value(Gauge gauge, uint64_t value);
+
+		private:
+			/// Ring buffer of a Stage's most recent durations.
+			struct StageSamples {
+				/// The total number of samples recorded. The next sample is written to this index modulo NUM_SAMPLES.
+				std::atomic<uint32_t> count;
+
+				/// Durations in nanoseconds, capped at UINT32_MAX.
+				std::atomic<uint32_t> samples[NUM_SAMPLES];
+			};
+
+			/// Event counts.
+			static std::atomic<uint64_t> counters_[static_cast<uint8_t>(Counter::NumCounters)];
+
+			/// Whether Stages are timed. Counters and Gauges are always updated.
+			static std::atomic<bool> enabled_;
+
+			/// Gauge values.
+			static std::atomic<uint64_t> gauges_[static_cast<uint8_t>(Gauge::NumGauges)];
+
+			/// Recent samples for each Stage.
+			static StageSamples stages_[static_cast<uint8_t>(Stage::NumStages)];
+	};
+}
+
+#endif // PERFORMANCEMONITOR_H
@@ -0,0 +1,198 @@
+#include <algorithm>
+#include <chrono>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QList>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+#include "tracerecorder.h"
+
+namespace PixelMaestroStudio {
+	// Static storage is zero-initialized, so every Event starts out unwritten
+	std::atomic<bool> TraceRecorder::enabled_(false);
+	TraceRecorder::Event TraceRecorder::events_[CAPACITY];
+	std::atomic<uint64_t> TraceRecorder::next_index_(0);
+	QHash<uint64_t, QString> TraceRecorder::thread_names_;
+	QMutex TraceRecorder::thread_names_mutex_;
+
+	const uint32_t TraceRecorder::CAPACITY;
+
+	/**
+	 * Starts a span.
+	 * @param name Span name. Must point to a string literal, since it's stored without being copied.
+	 */
+	TraceRecorder::Span::Span(const char* name) : name_(name), start_(TraceRecorder::get_enabled() ? TraceRecorder::get_time() : -1) { }
+
+	/**
+	 * Ends the span and records it.
+	 */
+	TraceRecorder::Span::~Span() {
+		if (start_ >= 0) {
+			TraceRecorder::record(name_, start_, TraceRecorder::get_time());
+		}
+	}
+
+	/**
+	 * Discards every recorded span.
+	 */
+	void TraceRecorder::clear() {
+		for (uint32_t i = 0; i < CAPACITY; i++) {
+			events_[i].sequence.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Returns whether spans are being recorded.
+	 * @return True if recording.
+	 */
+	bool TraceRecorder::get_enabled() {
+		return enabled_.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Returns an ID for the current thread.
+	 * @return Thread ID.
+	 */
+	uint64_t TraceRecorder::get_thread_id() {
+		return static_cast<uint64_t>(reinterpret_cast<quintptr>(QThread::currentThreadId()));
+	}
+
+	/**
+	 * Returns the current time on a clock shared by every thread.
+	 * @return Time in nanoseconds.
+	 */
+	int64_t TraceRecorder::get_time() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	/**
+	 * Writes a span into the ring buffer.
+	 * Each writer claims its own slot, so recording never blocks. The slot's sequence number tells readers when it's safe to read.
+	 * @param name Span name.
+	 * @param start Start time in nanoseconds.
+	 * @param end End time in nanoseconds.
+	 */
+	void TraceRecorder::record(const char* name, int64_t start, int64_t end) {
+		uint64_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+		Event& event = events_[index % CAPACITY];
+
+		event.sequence.store(0, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		event.name.store(name, std::memory_order_relaxed);
+		event.thread.store(get_thread_id(), std::memory_order_relaxed);
+		event.start.store(start, std::memory_order_relaxed);
+		event.duration.store(end - start, std::memory_order_relaxed);
+		event.sequence.store(index + 1, std::memory_order_release);
+	}
+
+	/**
+	 * Starts or stops recording spans.
+	 * Spans already recorded are kept until they're overwritten or cleared.
+	 * @param enabled If true, spans are recorded.
+	 */
+	void TraceRecorder::set_enabled(bool enabled) {
+		enabled_.store(enabled, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Sets the name shown for the current thread in exported traces.
+	 * @param name Thread name.
+	 */
+	void TraceRecorder::set_thread_name(const QString& name) {
+		QMutexLocker locker(&thread_names_mutex_);
+		thread_names_.insert(get_thread_id(), name);
+	}
+
+	/**
+	 * Exports the recorded spans as Chrome trace event JSON.
+	 * Spans that are being written while the export runs are skipped.
+	 * @return Trace JSON.
+	 */
+	QByteArray TraceRecorder::to_json() {
+		struct Record {
+			const char* name;
+			uint64_t thread;
+			int64_t start;
+			int64_t duration;
+		};
+
+		QVector<Record> spans;
+		spans.reserve(CAPACITY);
+		for (uint32_t i = 0; i < CAPACITY; i++) {
+			Event& event = events_[i];
+			uint64_t sequence = event.sequence.load(std::memory_order_acquire);
+			if (sequence == 0) continue;
+
+			Record span;
+			span.name = event.name.load(std::memory_order_relaxed);
+			span.thread = event.thread.load(std::memory_order_relaxed);
+			span.start = event.start.load(std::memory_order_relaxed);
+			span.duration = event.duration.load(std::memory_order_relaxed);
+
+			// If the slot was rewritten while reading it, skip it
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (event.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+			spans.append(span);
+		}
+
+		std::sort(spans.begin(), spans.end(), [](const Record& a, const Record& b) {
+			return a.start < b.start;
+		});
+
+		/*
+		 * Trace viewers expect small integer thread IDs, so number each thread in the order it appears.
+		 * Named threads are numbered first so that they keep the same IDs between exports.
+		 */
+		QHash<uint64_t, QString> thread_names;
+		{
+			QMutexLocker locker(&thread_names_mutex_);
+			thread_names = thread_names_;
+		}
+		QList<uint64_t> named_threads = thread_names.keys();
+		std::sort(named_threads.begin(), named_threads.end());
+		QHash<uint64_t, int> thread_indices;
+		for (uint64_t thread : named_threads) {
+			thread_indices.insert(thread, thread_indices.size());
+		}
+		for (const Record& span : spans) {
+			if (!thread_indices.contains(span.thread)) {
+				thread_indices.insert(span.thread, thread_indices.size());
+			}
+		}
+
+		QJsonArray events;
+		int64_t origin = spans.isEmpty() ? 0 : spans.first().start;
+		for (const Record& span : spans) {
+			QJsonObject event;
+			event["name"] = QString::fromLatin1(span.name);
+			event["ph"] = QStringLiteral("X");
+			event["pid"] = 1;
+			event["tid"] = thread_indices.value(span.thread);
+			event["ts"] = (span.start - origin) / 1000.0;
+			event["dur"] = span.duration / 1000.0;
+			events.append(event);
+		}
+
+		// Name each thread
+		for (uint64_t thread : named_threads) {
+			QJsonObject args;
+			args["name"] = thread_names.value(thread);
+
+			QJsonObject event;
+			event["name"] = QStringLiteral("thread_name");
+			event["ph"] = QStringLiteral("M");
+			event["pid"] = 1;
+			event["tid"] = thread_indices.value(thread);
+			event["args"] = args;
+			events.append(event);
+		}
+
+		QJsonObject root;
+		root["traceEvents"] = events;
+		root["displayTimeUnit"] = QStringLiteral("ms");
+		return QJsonDocument(root).toJson(QJsonDocument::Compact);
+	}
+}
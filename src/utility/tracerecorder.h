@@ -0,0 +1,82 @@
+/*
+ * TraceRecorder - Records timestamped spans from Studio's hot paths into a ring buffer, and exports them in Chrome's trace event format.
+ * Open the exported file in chrome://tracing or ui.perfetto.dev to see how each thread's work interleaves.
+ */
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <atomic>
+#include <stdint.h>
+
+namespace PixelMaestroStudio {
+	class TraceRecorder {
+		public:
+			/// Records the time between construction and destruction as a span.
+			class Span {
+				public:
+					explicit Span(const char* name);
+					~Span();
+
+				private:
+					/// Span name. Must point to a string literal.
+					const char* name_;
+
+					/// Start time in nanoseconds, or -1 if recording was disabled when the Span started.
+					int64_t start_;
+			};
+
+			/// The maximum number of spans kept. Once full, the oldest spans are overwritten.
+			static const uint32_t CAPACITY = 65536;
+
+			static void clear();
+			static bool get_enabled();
+			static void set_enabled(bool enabled);
+			static void set_thread_name(const QString& name);
+			static QByteArray to_json();
+
+		private:
+			/// A single completed span.
+			struct Event {
+				/// Index of the span plus one once the span is fully written, or 0 while it's being written.
+				std::atomic<uint64_t> sequence;
+
+				/// Span name.
+				std::atomic<const char*> name;
+
+				/// ID of the thread that recorded the span.
+				std::atomic<uint64_t> thread;
+
+				/// Start time in nanoseconds.
+				std::atomic<int64_t> start;
+
+				/// Duration in nanoseconds.
+				std::atomic<int64_t> duration;
+			};
+
+			/// Whether spans are recorded.
+			static std::atomic<bool> enabled_;
+
+			/// Recorded spans.
+			static Event events_[CAPACITY];
+
+			/// The total number of spans recorded. The next span is written to this index modulo CAPACITY.
+			static std::atomic<uint64_t> next_index_;
+
+			/// Display name of each thread that recorded spans.
+			static QHash<uint64_t, QString> thread_names_;
+
+			/// Guards thread_names_.
+			static QMutex thread_names_mutex_;
+
+			static uint64_t get_thread_id();
+			static int64_t get_time();
+			static void record(const char* name, int64_t start, int64_t end);
+	};
+}
+
+#endif // TRACERECORDER_H
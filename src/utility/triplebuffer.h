@@ -0,0 +1,80 @@
+/*
+ * TripleBuffer - Lock-free handoff of data from a single producer thread to a single consumer thread.
+ *
+ * The producer always has a buffer to write to and the consumer always has a complete buffer to read from.
+ * Publishing swaps the producer's buffer with a shared "middle" buffer, and consuming swaps the consumer's buffer with the middle buffer if it holds newer data.
+ * Neither side ever waits on the other. If the producer publishes more than once between consumes, the older data is dropped.
+ */
+
+#ifndef TRIPLEBUFFER_H
+#define TRIPLEBUFFER_H
+
+#include <atomic>
+#include <stdint.h>
+
+namespace PixelMaestroStudio {
+	template <typename T>
+	class TripleBuffer {
+		public:
+			/**
+			 * Returns the buffer that the consumer is reading from.
+			 * @return Front buffer.
+			 */
+			T& get_front() {
+				return buffers_[front_];
+			}
+
+			/**
+			 * Returns the buffer that the producer is writing to.
+			 * @return Back buffer.
+			 */
+			T& get_back() {
+				return buffers_[back_];
+			}
+
+			/**
+			 * Makes the most recently published buffer the front buffer.
+			 * Only call this from the consumer thread.
+			 * @return True if a new buffer was published since the last call.
+			 */
+			bool consume() {
+				if ((middle_.load(std::memory_order_relaxed) & DIRTY) == 0) {
+					return false;
+				}
+
+				uint8_t previous = middle_.exchange(front_, std::memory_order_acq_rel);
+				front_ = previous & INDEX;
+				return true;
+			}
+
+			/**
+			 * Hands the back buffer to the consumer and takes a free buffer to write the next frame into.
+			 * Only call this from the producer thread.
+			 */
+			void publish() {
+				uint8_t previous = middle_.exchange(back_ | DIRTY, std::memory_order_acq_rel);
+				back_ = previous & INDEX;
+			}
+
+		private:
+			/// Flags the middle buffer as holding data that hasn't been consumed yet.
+			static const uint8_t DIRTY = 0x4;
+
+			/// Masks the buffer index out of the middle buffer's state.
+			static const uint8_t INDEX = 0x3;
+
+			/// The three buffers.
+			T buffers_[3];
+
+			/// Index of the buffer owned by the producer.
+			uint8_t back_ = 0;
+
+			/// Index of the buffer owned by the consumer.
+			uint8_t front_ = 1;
+
+			/// Index of the buffer waiting to be swapped, combined with the DIRTY flag.
+			std::atomic<uint8_t> middle_ {2};
+	};
+}
+
+#endif // TRIPLEBUFFER_H
@@ -9,9 +9,15 @@ namespace PixelMaestroStudio {
 			maestro_control_widget_(maestro_control_widget) {
 		ui->setupUi(this);
 
+		ui->boltCountSpinBox->blockSignals(true);
 		ui->boltCountSpinBox->setValue(animation.get_bolt_count());
+		ui->boltCountSpinBox->blockSignals(false);
+		ui->forkChanceSpinBox->blockSignals(true);
 		ui->forkChanceSpinBox->setValue(animation.get_fork_chance());
+		ui->forkChanceSpinBox->blockSignals(false);
+		ui->driftSpinBox->blockSignals(true);
 		ui->driftSpinBox->setValue(animation.get_drift());
+		ui->driftSpinBox->blockSignals(false);
 	}
 
 	LightningAnimationControlWidget::~LightningAnimationControlWidget() {
@@ -9,8 +9,12 @@ namespace PixelMaestroStudio {
 			maestro_control_widget_(maestro_control_widget) {
 		ui->setupUi(this);
 
+		ui->resolutionDoubleSpinBox->blockSignals(true);
 		ui->resolutionDoubleSpinBox->setValue(animation.get_resolution());
+		ui->resolutionDoubleSpinBox->blockSignals(false);
+		ui->sizeDoubleSpinBox->blockSignals(true);
 		ui->sizeDoubleSpinBox->setValue(animation.get_size());
+		ui->sizeDoubleSpinBox->blockSignals(false);
 	}
 
 	PlasmaAnimationControlWidget::~PlasmaAnimationControlWidget() {
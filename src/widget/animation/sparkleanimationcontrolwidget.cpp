@@ -9,7 +9,9 @@ namespace PixelMaestroStudio {
 			maestro_control_widget_(maestro_control_widget) {
 		ui->setupUi(this);
 
+		ui->thresholdSpinBox->blockSignals(true);
 		ui->thresholdSpinBox->setValue(animation.get_threshold());
+		ui->thresholdSpinBox->blockSignals(false);
 	}
 
 	SparkleAnimationControlWidget::~SparkleAnimationControlWidget() {
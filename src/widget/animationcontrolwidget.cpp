@@ -1,8 +1,10 @@
+#include <QMutexLocker>
 #include <QTime>
 #include <QWidget>
 #include "animationcontrolwidget.h"
 #include "ui_animationcontrolwidget.h"
 #include "animation/animation.h"
+#include "controller/maestrocontroller.h"
 #include "controller/palettecontroller.h"
 #include "utility/uiutility.h"
 #include "widget/animation/fireanimationcontrolwidget.h"
@@ -68,13 +70,19 @@ namespace PixelMaestroStudio {
 		}
 		else {
 			// If the Section has an active Animation, update it
-			Animation* animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
-			if (animation != nullptr) {
+			bool has_animation = false;
+			{
+				QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
+				Animation* animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
+				has_animation = (animation != nullptr);
+
 				// First, check to see if the Animation types match. If so, do nothing
-				if (animation->get_type() == (AnimationType)(index - 1)) {
+				if (has_animation && animation->get_type() == (AnimationType)(index - 1)) {
 					return;
 				}
+			}
 
+			if (has_animation) {
 				// Otherwise, replace the Animation, preserving options
 				maestro_control_widget.run_cue(
 					maestro_control_widget.section_handler->set_animation(
@@ -100,17 +108,29 @@ namespace PixelMaestroStudio {
 				on_reverseCheckBox_toggled(ui->reverseCheckBox->isChecked());
 				on_orientationComboBox_currentIndexChanged(ui->orientationComboBox->currentIndex());
 
-				animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
-				ui->cycleIntervalSlider->setValue(animation->get_timer()->get_interval());
-				ui->delayIntervalSlider->setValue(animation->get_timer()->get_delay());
+				// Changing the sliders runs a Cue, so read the timer first
+				uint16_t interval, delay;
+				{
+					QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
+					Animation* animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
+					interval = animation->get_timer()->get_interval();
+					delay = animation->get_timer()->get_delay();
+				}
+				ui->cycleIntervalSlider->setValue(interval);
+				ui->delayIntervalSlider->setValue(delay);
 			}
 
 			// Set center
-			animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
-			ui->centerXSpinBox->setValue(animation->get_center().x);
-			ui->centerYSpinBox->setValue(animation->get_center().y);
+			Point center(0, 0);
+			{
+				QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
+				center = maestro_control_widget.section_control_widget_->get_active_section().get_animation()->get_center();
+			}
+			ui->centerXSpinBox->setValue(center.x);
+			ui->centerYSpinBox->setValue(center.y);
 			on_centerXSpinBox_editingFinished();
 
+			QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
 			set_advanced_controls(maestro_control_widget.section_control_widget_->get_active_section().get_animation());
 		}
 
@@ -142,7 +162,11 @@ namespace PixelMaestroStudio {
 		);
 
 		// Refresh box in case the cycle was adjusted
-		uint8_t cycle = maestro_control_widget.section_control_widget_->get_active_section().get_animation()->get_cycle_index();
+		uint8_t cycle;
+		{
+			QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
+			cycle = maestro_control_widget.section_control_widget_->get_active_section().get_animation()->get_cycle_index();
+		}
 		if (cycle != ui->currentCycleSpinBox->value()) {
 			ui->currentCycleSpinBox->setValue(cycle);
 		}
@@ -249,7 +273,11 @@ namespace PixelMaestroStudio {
 				)
 			);
 
-			uint8_t current_cycle = maestro_control_widget.section_control_widget_->get_active_section().get_animation()->get_cycle_index();
+			uint8_t current_cycle;
+			{
+				QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
+				current_cycle = maestro_control_widget.section_control_widget_->get_active_section().get_animation()->get_cycle_index();
+			}
 			ui->currentCycleSpinBox->setValue(current_cycle);
 		}
 		else {
@@ -280,8 +308,10 @@ namespace PixelMaestroStudio {
 
 	/**
 	 * Updates the UI based on the active Section.
+	 * The Maestro stays locked throughout, since the simulation thread can replace the Animation at any time. Signals are blocked so that no Cues run in the meantime.
 	 */
 	void AnimationControlWidget::refresh() {
+		QMutexLocker locker(maestro_control_widget.get_maestro_controller()->get_maestro_mutex());
 		Animation* animation = maestro_control_widget.section_control_widget_->get_active_section().get_animation();
 
 		// If there is no Animation, select 'None' and exit.
@@ -352,6 +382,7 @@ namespace PixelMaestroStudio {
 
 	/**
 	 * Displays extra controls for Animations that take custom parameters.
+	 * The Maestro mutex must be held, since the controls read their initial values from the Animation.
 	 * @param animation New Animation.
 	 */
 	void AnimationControlWidget::set_advanced_controls(Animation *animation) {
@@ -1,12 +1,16 @@
+#include <algorithm>
 #include <QFileDialog>
 #include <QHBoxLayout>
 #include <QKeyEvent>
 #include <QLayout>
 #include <QMessageBox>
+#include <QMutexLocker>
 #include <QPushButton>
 #include <QTime>
+#include <QVector>
 #include "canvascontrolwidget.h"
 #include "ui_canvascontrolwidget.h"
+#include "controller/maestrocontroller.h"
 #include "utility/canvasutility.h"
 #include "utility/uiutility.h"
 #include "widget/palettecontrolwidget.h"
@@ -102,6 +106,24 @@ namespace PixelMaestroStudio {
 		set_circle_controls_enabled(checked);
 	}
 
+	/**
+	 * Returns the active Canvas' current frame index.
+	 * @return Current frame index.
+	 */
+	uint16_t CanvasControlWidget::get_current_frame_index() {
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+		return maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_current_frame_index();
+	}
+
+	/**
+	 * Returns the number of frames in the active Canvas.
+	 * @return Number of frames.
+	 */
+	uint16_t CanvasControlWidget::get_num_frames() {
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+		return maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_num_frames();
+	}
+
 	/**
 	 * Returns the index of the selected Canvas Palette color.
 	 * @return Canvas Palette color index.
@@ -183,7 +205,7 @@ namespace PixelMaestroStudio {
 		int frame = ui->currentFrameSpinBox->value();
 
 		// If the selected frame exceeds the number of frames, set to the number of frames.
-		int num_frames = maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_num_frames();
+		int num_frames = get_num_frames();
 		if (frame >= num_frames) {
 			frame = num_frames - 1;
 			ui->currentFrameSpinBox->blockSignals(true);
@@ -264,9 +286,19 @@ namespace PixelMaestroStudio {
 		else if (checked_button == ui->replaceToolButton) {
 			// Replace all instances of the selected color index in the current frame with the new color index.
 			Section& active_section = maestro_control_widget_.section_control_widget_->get_active_section();
-			Point& dimensions = active_section.get_dimensions();
 
-			uint8_t* frame = active_section.get_canvas()->get_frame(active_section.get_canvas()->get_current_frame_index());
+			// Work on a copy of the frame, since the Canvas can change while the Cue is being built
+			Point dimensions(0, 0);
+			QVector<uint8_t> frame;
+			{
+				QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+				Canvas* canvas = active_section.get_canvas();
+				dimensions = active_section.get_dimensions();
+				const uint8_t* canvas_frame = canvas->get_frame(canvas->get_current_frame_index());
+				frame = QVector<uint8_t>(static_cast<int>(dimensions.size()));
+				std::copy(canvas_frame, canvas_frame + dimensions.size(), frame.begin());
+			}
+
 			uint32_t target_point = dimensions.get_inline_index(ui->originXSpinBox->value(), ui->originYSpinBox->value());
 			uint8_t target_index = frame[target_point];
 
@@ -287,7 +319,7 @@ namespace PixelMaestroStudio {
 					ui->currentFrameSpinBox->value(),
 					dimensions.x,
 					dimensions.y,
-					frame
+					frame.data()
 				)
 			);
 		}
@@ -336,7 +368,12 @@ namespace PixelMaestroStudio {
 	 */
 	void CanvasControlWidget::on_enableCheckBox_toggled(bool checked) {
 		// Check to see if a Canvas already exists. If it does, warn the user that the current Canvas will be erased.
-		if (!checked && maestro_control_widget_.section_control_widget_->get_active_section().get_canvas() != nullptr) {
+		bool has_canvas;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			has_canvas = (maestro_control_widget_.section_control_widget_->get_active_section().get_canvas() != nullptr);
+		}
+		if (!checked && has_canvas) {
 			QMessageBox::StandardButton confirm;
 			confirm = QMessageBox::question(this, "Clear Canvas", "This will clear the Canvas. Are you sure you want to continue?", QMessageBox::Yes|QMessageBox::No);
 			if (confirm == QMessageBox::Yes) {
@@ -382,7 +419,7 @@ namespace PixelMaestroStudio {
 	 */
 	void CanvasControlWidget::on_frameCountSpinBox_editingFinished() {
 		int new_max = ui->frameCountSpinBox->value();
-		if (new_max != maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_num_frames()) {
+		if (new_max != get_num_frames()) {
 
 			QMessageBox::StandardButton confirm;
 			confirm = QMessageBox::question(this, "Clear Canvas", "This will clear the Canvas. Are you sure you want to continue?", QMessageBox::Yes|QMessageBox::No);
@@ -406,7 +443,7 @@ namespace PixelMaestroStudio {
 			else {
 				// Reset frame count
 				ui->frameCountSpinBox->blockSignals(true);
-				ui->frameCountSpinBox->setValue(maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_num_frames());
+				ui->frameCountSpinBox->setValue(get_num_frames());
 				ui->frameCountSpinBox->blockSignals(false);
 			}
 		}
@@ -467,6 +504,8 @@ namespace PixelMaestroStudio {
 			CanvasUtility::load_image(filename, *canvas, &maestro_control_widget_);
 
 			// Update UI based on new canvas
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			canvas = maestro_control_widget_.section_control_widget_->get_active_section().get_canvas();
 			ui->frameCountSpinBox->blockSignals(true);
 			ui->frameCountSpinBox->setValue(canvas->get_num_frames());
 			ui->frameCountSpinBox->blockSignals(false);
@@ -495,7 +534,7 @@ namespace PixelMaestroStudio {
 		);
 
 		ui->currentFrameSpinBox->blockSignals(true);
-		ui->currentFrameSpinBox->setValue(maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_current_frame_index());
+		ui->currentFrameSpinBox->setValue(get_current_frame_index());
 		ui->currentFrameSpinBox->blockSignals(false);
 	}
 
@@ -511,7 +550,7 @@ namespace PixelMaestroStudio {
 		);
 
 		ui->currentFrameSpinBox->blockSignals(true);
-		ui->currentFrameSpinBox->setValue(maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_current_frame_index());
+		ui->currentFrameSpinBox->setValue(get_current_frame_index());
 		ui->currentFrameSpinBox->blockSignals(false);
 	}
 
@@ -534,7 +573,7 @@ namespace PixelMaestroStudio {
 				)
 			);
 			ui->currentFrameSpinBox->blockSignals(true);
-			ui->currentFrameSpinBox->setValue(maestro_control_widget_.section_control_widget_->get_active_section().get_canvas()->get_current_frame_index());
+			ui->currentFrameSpinBox->setValue(get_current_frame_index());
 			ui->currentFrameSpinBox->blockSignals(false);
 		}
 		else {
@@ -633,8 +672,10 @@ namespace PixelMaestroStudio {
 
 	/**
 	 * Updates the UI.
+	 * The Maestro stays locked throughout, since the simulation thread can replace the Canvas at any time. Signals are blocked so that no Cues run in the meantime.
 	 */
 	void CanvasControlWidget::refresh() {
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
 		ui->enableCheckBox->blockSignals(true);
 		ui->frameCountSpinBox->blockSignals(true);
 		ui->currentFrameSpinBox->blockSignals(true);
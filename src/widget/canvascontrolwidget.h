@@ -91,6 +91,8 @@ namespace PixelMaestroStudio {
 			Ui::CanvasControlWidget *ui;
 
 			void add_palette_to_selection(const Palette& palette);
+			uint16_t get_current_frame_index();
+			uint16_t get_num_frames();
 			void populate_palette_canvas_color_selection(PaletteController::PaletteWrapper& palette_wrapper);
 			void set_controls_enabled(bool enabled);
 			void set_frame_interval();
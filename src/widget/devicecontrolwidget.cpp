@@ -2,6 +2,7 @@
  * DeviceControlWidget - Widget for managing USB/serial devices.
  */
 
+#include <QFutureWatcher>
 #include <QList>
 #include <QMessageBox>
 #include <QSerialPort>
@@ -18,6 +19,7 @@
 #include "dialog/sectionmapdialog.h"
 #include "devicecontrolwidget.h"
 #include "ui_devicecontrolwidget.h"
+#include "utility/performancemonitor.h"
 #include "controller/devicecontroller.h"
 #include "controller/devicethreadcontroller.h"
 
@@ -39,6 +41,7 @@ namespace PixelMaestroStudio {
 
 			// If the device is set to auto-connect, try connecting
 			DeviceController& serial_device = serial_devices_.last();
+			watch_device(serial_device);
 			if (serial_device.get_autoconnect()) {
 				serial_device.connect();
 			}
@@ -49,12 +52,20 @@ namespace PixelMaestroStudio {
 		refresh_device_list();
 	}
 
+	/**
+	 * Returns the list of devices.
+	 * @return Devices.
+	 */
+	const QVector<DeviceController>& DeviceControlWidget::get_devices() const {
+		return serial_devices_;
+	}
+
 	/**
 	 * Returns the Maestro Cuefile.
 	 * @return Maestro Cuefile.
 	 */
-	QByteArray* DeviceControlWidget::get_maestro_cue() {
-		return &maestro_cue_;
+	QByteArray DeviceControlWidget::get_maestro_cue() {
+		return maestro_control_widget_.get_maestro_controller()->get_cuefile_cache().get_cuefile();
 	}
 
 	void DeviceControlWidget::on_addDeviceButton_clicked() {
@@ -86,15 +97,10 @@ namespace PixelMaestroStudio {
 
 		DeviceController device = serial_devices_.at(selected);
 		if (!device.get_open()) {
-			if (device.connect()) {
-				refresh_device_list();
-			}
-			else {
-				QString error = "Unable to connect to device at " + device.get_port_name();
-				if (device.get_device()) error += ": " + device.get_device()->errorString();
-
-				QMessageBox::warning(this, "Unable to Connect", error);
-			}
+			// The device answers through update_device_connection() or show_device_error()
+			pending_ports_.insert(device.get_port_name());
+			ui->connectPushButton->setEnabled(false);
+			device.connect();
 		}
 		else {
 			QMessageBox::information(this, "Device Already Connected", "This device is already connected.");
@@ -102,13 +108,37 @@ namespace PixelMaestroStudio {
 	}
 
 
+	/**
+	 * Updates the device list after a device connects or disconnects.
+	 */
+	void DeviceControlWidget::update_device_connection() {
+		DeviceThreadController* thread = qobject_cast<DeviceThreadController*>(sender());
+		if (thread != nullptr) {
+			pending_ports_.remove(thread->objectName());
+		}
+		refresh_device_list();
+	}
+
+	/**
+	 * Shows an error from a device that the user asked to connect or disconnect.
+	 * @param error Description of the error.
+	 */
+	void DeviceControlWidget::show_device_error(const QString& error) {
+		DeviceThreadController* thread = qobject_cast<DeviceThreadController*>(sender());
+		if (thread != nullptr && pending_ports_.remove(thread->objectName())) {
+			QMessageBox::warning(this, "Device Error", "Device on port " + thread->objectName() + ": " + error);
+		}
+		refresh_device_list();
+	}
+
 	/**
 	 * Opens the CueInterpreter dialog for the selected device.
 	 */
 	void DeviceControlWidget::on_previewButton_clicked() {
+		QByteArray maestro_cue = get_maestro_cue();
 		CueInterpreterDialog dialog(this,
-									reinterpret_cast<uint8_t*>(maestro_cue_.data()),
-									static_cast<uint32_t>(maestro_cue_.size()));
+									reinterpret_cast<uint8_t*>(maestro_cue.data()),
+									static_cast<uint32_t>(maestro_cue.size()));
 		dialog.exec();
 	}
 
@@ -121,12 +151,10 @@ namespace PixelMaestroStudio {
 
 		DeviceController device = serial_devices_.at(selected_index);
 
-		if (device.disconnect()) {
-			refresh_device_list();
-		}
-		else {
-			QMessageBox::warning(this, "Unable to Disconnect", QString("Unable to disconnect device on port " + device.get_port_name() + ": " + device.get_device()->errorString()));
-		}
+		// The device answers through update_device_connection() or show_device_error()
+		pending_ports_.insert(device.get_port_name());
+		ui->disconnectPushButton->setEnabled(false);
+		device.disconnect();
 	}
 
 	void DeviceControlWidget::on_removeDeviceButton_clicked() {
@@ -143,14 +171,46 @@ namespace PixelMaestroStudio {
 
 	/**
 	 * Transmits the Maestro's Cuefile to the selected device.
+	 * While an upload is running, including while its Cuefile is being generated, this cancels it instead.
 	 */
 	void DeviceControlWidget::on_uploadButton_clicked() {
-		// "ROMEND" flags to the Arduino that we're done transmitting the Cuefile
-		QByteArray out = maestro_cue_.append("ROMEND");
-		write_to_device(serial_devices_[ui->serialOutputListWidget->currentRow()],
-				static_cast<const char*>(maestro_cue_),
-				maestro_cue_.size(),
-				true);
+		if (!upload_thread_.isNull()) {
+			upload_thread_->cancel(upload_write_id_);
+			return;
+		}
+
+		// The Cuefile hasn't been sent yet, so drop it once it's generated
+		if (!upload_watcher_.isNull()) {
+			upload_watcher_->disconnect(this);
+			upload_watcher_->deleteLater();
+			upload_watcher_.clear();
+			refresh_upload_button();
+			return;
+		}
+
+		int selected = ui->serialOutputListWidget->currentRow();
+		if (selected < 0) return;
+		QString port_name = serial_devices_[selected].get_port_name();
+
+		// Build the Cuefile in the background and send it once it's ready
+		QFutureWatcher<QByteArray>* watcher = new QFutureWatcher<QByteArray>(this);
+		upload_watcher_ = watcher;
+		connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher, port_name]() {
+			upload_watcher_.clear();
+			watcher->deleteLater();
+
+			// The device list might have changed in the meantime
+			for (DeviceController& device : serial_devices_) {
+				if (device.get_port_name() == port_name) {
+					// "ROMEND" flags to the Arduino that we're done transmitting the Cuefile
+					write_to_device(device, watcher->result().append("ROMEND"), true);
+					break;
+				}
+			}
+			refresh_upload_button();
+		});
+		refresh_upload_button();
+		watcher->setFuture(maestro_control_widget_.get_maestro_controller()->get_cuefile_cache().generate());
 	}
 
 	void DeviceControlWidget::on_serialOutputListWidget_currentRowChanged(int currentRow) {
@@ -162,7 +222,7 @@ namespace PixelMaestroStudio {
 
 		ui->connectPushButton->setEnabled(!connected);
 		ui->disconnectPushButton->setEnabled(connected);
-		ui->uploadButton->setEnabled(connected);
+		refresh_upload_button();
 		ui->uploadProgressBar->setValue(0);
 
 		ui->editDeviceButton->setEnabled(currentRow >= 0);
@@ -172,7 +232,10 @@ namespace PixelMaestroStudio {
 	void DeviceControlWidget::refresh_device_list() {
 		ui->serialOutputListWidget->clear();
 		bool connected_devices = false;
-		for (DeviceController device : serial_devices_) {
+		for (DeviceController& device : serial_devices_) {
+			// Devices might have been added since the last refresh
+			watch_device(device);
+
 			QListWidgetItem* item = new QListWidgetItem(device.get_port_name());
 			if (device.get_open()) {
 				item->setTextColor(Qt::white);
@@ -196,19 +259,34 @@ namespace PixelMaestroStudio {
 
 		int selected = ui->serialOutputListWidget->currentRow();
 		if (selected >= 0) {
-			ui->uploadButton->setEnabled(serial_devices_[selected].get_open());
 			ui->serialOutputListWidget->setCurrentRow(selected);
 		}
 		else {
-			ui->uploadButton->setEnabled(false);
 			ui->connectPushButton->setEnabled(false);
 			ui->disconnectPushButton->setEnabled(false);
 		}
+		refresh_upload_button();
 
 		ui->editDeviceButton->setEnabled(selected >= 0);
 		ui->removeDeviceButton->setEnabled(selected >= 0);
 	}
 
+	/**
+	 * Updates the upload button for the selected device.
+	 * From the time an upload starts until its write finishes, the button cancels the upload. The device being uploaded to might have been removed in the meantime.
+	 */
+	void DeviceControlWidget::refresh_upload_button() {
+		if (!upload_watcher_.isNull() || !upload_thread_.isNull()) {
+			ui->uploadButton->setText("Cancel");
+			ui->uploadButton->setEnabled(true);
+			return;
+		}
+
+		int selected = ui->serialOutputListWidget->currentRow();
+		ui->uploadButton->setText("Upload");
+		ui->uploadButton->setEnabled(selected >= 0 && selected < serial_devices_.size() && serial_devices_[selected].get_open());
+	}
+
 	/**
 	 * Updates the Maestro's Cuefile.
 	 * This also sends the Cue to all connected devices.
@@ -219,8 +297,6 @@ namespace PixelMaestroStudio {
 		CueController* controller = &this->maestro_control_widget_.get_maestro_controller()->get_maestro().get_cue_controller();
 
 		for (DeviceController device : serial_devices_) {
-			// TODO: Move to separate thread
-
 			// Copy the Cue for each device
 			QByteArray out = QByteArray(reinterpret_cast<const char*>(cue), size);
 
@@ -260,10 +336,7 @@ namespace PixelMaestroStudio {
 			}
 
 			if (device.get_open() && device.get_real_time_refresh_enabled()) {
-				write_to_device(device,
-								out.data(),
-								out.size(),
-								false);
+				write_to_device(device, out);
 			}
 		}
 
@@ -312,57 +385,88 @@ namespace PixelMaestroStudio {
 	 */
 	void DeviceControlWidget::set_progress_bar(int val) {
 		ui->uploadProgressBar->setValue(val);
-		// Disable upload button while sending data
-		ui->uploadButton->setEnabled(!(val > 0 && val < 100));
 	}
 
 	/**
-	 * Regenerates the Maestro Cuefile and updates the size in the UI.
-	 *
-	 * TODO: Move to separate thread
+	 * Re-encodes the parts of the Maestro Cuefile that changed and updates the size in the UI.
 	 */
 	void DeviceControlWidget::update_cuefile_size() {
-		// Calculate and display the size of the current Maestro configuration
-		QDataStream datastream(&maestro_cue_, QIODevice::Truncate);
+		// Only one update runs at a time. Changes made while it's running are picked up by running it again once it's done.
+		if (!cuefile_size_watcher_.isNull()) {
+			cuefile_size_stale_ = true;
+			return;
+		}
 
-		MaestroController* controller = maestro_control_widget_.get_maestro_controller();
+		QFutureWatcher<uint32_t>* watcher = new QFutureWatcher<uint32_t>(this);
+		cuefile_size_watcher_ = watcher;
+		connect(watcher, &QFutureWatcher<uint32_t>::finished, this, [this, watcher]() {
+			uint32_t size = watcher->result();
+			ui->fileSizeLineEdit->setText(locale_.toString(size));
+			PerformanceMonitor::set_value(PerformanceMonitor::Gauge::CuefileSize, size);
+
+			cuefile_size_watcher_.clear();
+			watcher->deleteLater();
+			if (cuefile_size_stale_) {
+				cuefile_size_stale_ = false;
+				update_cuefile_size();
+			}
+		});
 
-		// Generate the Cuefile
-		controller->save_maestro_to_datastream(datastream);
+		// Only the Layers touched since the last update are encoded again
+		watcher->setFuture(maestro_control_widget_.get_maestro_controller()->get_cuefile_cache().update_in_background());
+	}
 
-		ui->fileSizeLineEdit->setText(locale_.toString(maestro_cue_.size()));
+	/**
+	 * Listens for a device connecting, disconnecting, or failing to do either.
+	 * Safe to call more than once for the same device.
+	 * @param device Device to listen to.
+	 */
+	void DeviceControlWidget::watch_device(DeviceController& device) {
+		DeviceThreadController* thread = device.get_thread();
+		connect(thread, &DeviceThreadController::connected, this, &DeviceControlWidget::update_device_connection, Qt::UniqueConnection);
+		connect(thread, &DeviceThreadController::disconnected, this, &DeviceControlWidget::update_device_connection, Qt::UniqueConnection);
+		connect(thread, &DeviceThreadController::error, this, &DeviceControlWidget::show_device_error, Qt::UniqueConnection);
 	}
 
 	/**
-	 * Sends serial output to device in a separate thread.
+	 * Queues output on the device's I/O thread.
 	 * @param device Device to send output to.
 	 * @param out Data to send.
-	 * @param size Size of data to send.
+	 * @param progress If true, shows the write's progress and turns the upload button into a cancel button until it's done.
 	 */
-	void DeviceControlWidget::write_to_device(DeviceController& device, const char *out, const int size, bool progress) {
-		DeviceThreadController* thread = new DeviceThreadController(device,
-														  out,
-														  size);
-
-		connect(thread, &DeviceThreadController::finished, thread, &DeviceThreadController::deleteLater);
-
-		if (progress) {
-			connect(thread, &DeviceThreadController::progress_changed, this, &DeviceControlWidget::set_progress_bar);
-		}
-
-		/*
-		 * NOTE: Device pointer becomes invalid when using Thread::start(), likely due to invalid memory access.
-		 *		Need to make the DeviceThreadController and output thread-safe before sending it to a separate thread.
-		 *
-		 *		Maybe convert threads to QFuture and use QFutureWatcher to update progress? https://doc.qt.io/qt-5/qfuturewatcher.html#details
-		 *
-		 */
+	void DeviceControlWidget::write_to_device(DeviceController& device, const QByteArray& out, bool progress) {
+		uint32_t write_id = device.write(out);
+		if (!progress) return;
+
+		DeviceThreadController* thread = device.get_thread();
+		upload_thread_ = thread;
+		upload_write_id_ = write_id;
+		refresh_upload_button();
+
+		// Deleting the context disconnects both handlers once the upload is done
+		QObject* context = new QObject(this);
+		connect(thread, &DeviceThreadController::progress_changed, context, [this, write_id](uint32_t id, int progress) {
+			if (id == write_id) {
+				set_progress_bar(progress);
+			}
+		});
+		connect(thread, &DeviceThreadController::write_finished, context, [this, context, write_id](uint32_t id, bool completed) {
+			if (id != write_id) return;
 
-		//thread->start();
-		thread->run();
+			if (!completed) {
+				set_progress_bar(0);
+			}
+			upload_thread_.clear();
+			refresh_upload_button();
+			context->deleteLater();
+		});
 	}
 
 	DeviceControlWidget::~DeviceControlWidget() {
+		// Don't make the user wait for an upload to finish
+		if (!upload_thread_.isNull()) {
+			upload_thread_->cancel(upload_write_id_);
+		}
 		for (DeviceController& device : serial_devices_) {
 			device.disconnect();
 		}
@@ -6,11 +6,16 @@
 #define DEVICECONTROLWIDGET_H
 
 #include <QBuffer>
+#include <QFutureWatcher>
 #include <QLocale>
+#include <QPointer>
+#include <QSet>
 #include <QSharedPointer>
+#include <QString>
 #include <QVector>
 #include <QWidget>
 #include "controller/devicecontroller.h"
+#include "controller/devicethreadcontroller.h"
 #include "dialog/adddevicedialog.h"
 #include "widget/maestrocontrolwidget.h"
 
@@ -26,7 +31,8 @@ namespace PixelMaestroStudio {
 		public:
 			explicit DeviceControlWidget(QWidget *parent = 0);
 			~DeviceControlWidget();
-			QByteArray* get_maestro_cue();
+			const QVector<DeviceController>& get_devices() const;
+			QByteArray get_maestro_cue();
 			void run_cue(uint8_t* cue, int size);
 			void save_devices();
 			void update_cuefile_size();
@@ -40,6 +46,9 @@ namespace PixelMaestroStudio {
 
 			void set_progress_bar(int val);
 
+			void update_device_connection();
+			void show_device_error(const QString& error);
+
 			void on_addDeviceButton_clicked();
 
 			void on_editDeviceButton_clicked();
@@ -50,17 +59,34 @@ namespace PixelMaestroStudio {
 			MaestroControlWidget& maestro_control_widget_;
 			Ui::DeviceControlWidget *ui;
 
-			QLocale locale_ = QLocale::system();
+			/// Whether the Maestro changed while its Cuefile size was being updated.
+			bool cuefile_size_stale_ = false;
 
-			/// Stores the current Maestro configuration in Cue form.
-			QByteArray maestro_cue_;
+			/// Updates the Cuefile size shown in the widget. Null if no update is running.
+			QPointer<QFutureWatcher<uint32_t>> cuefile_size_watcher_;
+
+			QLocale locale_ = QLocale::system();
 
 			/// List of activated USB devices.
 			QVector<DeviceController> serial_devices_;
 
+			/// Ports of devices that the user asked to connect or disconnect, and that haven't responded yet. Errors are only shown for these.
+			QSet<QString> pending_ports_;
+
+			/// Thread of the device currently receiving a Cuefile. Null if no upload is running.
+			QPointer<DeviceThreadController> upload_thread_;
+
+			/// Generates the Cuefile for an upload that hasn't been sent yet. Null if no Cuefile is being generated.
+			QPointer<QFutureWatcher<QByteArray>> upload_watcher_;
+
+			/// The write sending the Cuefile, if an upload is running.
+			uint32_t upload_write_id_ = 0;
+
 			void populate_serial_devices();
 			void refresh_device_list();
-			void write_to_device(DeviceController& device, const char* out, const int size, bool progress = false);
+			void refresh_upload_button();
+			void watch_device(DeviceController& device);
+			void write_to_device(DeviceController& device, const QByteArray& out, bool progress = false);
 	};
 }
 
@@ -13,6 +13,8 @@
 #include "ui_maestrocontrolwidget.h"
 #include "utility.h"
 #include "utility/canvasutility.h"
+#include "utility/performancemonitor.h"
+#include "utility/tracerecorder.h"
 #include "utility/uiutility.h"
 #include "window/mainwindow.h"
 
@@ -83,8 +85,17 @@ namespace PixelMaestroStudio {
 		return modified_;
 	}
 
+	/**
+	 * Returns the number of times the Maestro has been modified.
+	 * @return Modification count.
+	 */
+	uint32_t MaestroControlWidget::get_modification_count() const {
+		return modification_count_;
+	}
+
 	/**
 	 * Loads a Cuefile into the Maestro.
+	 * Cues are run straight on the Maestro without being added to the event history or sent to devices, and the UI is refreshed once at the end.
 	 * @param byte_array Byte array containing the Cuefile.
 	 */
 	void MaestroControlWidget::load_cuefile(const QByteArray& byte_array) {
@@ -92,14 +103,9 @@ namespace PixelMaestroStudio {
 		 * To test the Cuefile, we read each byte into a virtual Maestro.
 		 * If it runs, we then pass it to the actual Maestro.
 		 */
-		Maestro virtual_maestro(nullptr, 0);
-		virtual_maestro.set_cue_controller(UINT16_MAX);
-		for (char byte_char : byte_array) {
-			uint8_t byte = static_cast<uint8_t>(byte_char);
-
-			if (virtual_maestro.get_cue_controller().read(byte)) {
-				run_cue(virtual_maestro.get_cue_controller().get_buffer(), RunTarget::Local);
-			}
+		{
+			PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::CuefileLoad);
+			maestro_controller_->run_cuefile(byte_array, show_control_widget_->get_maestro_locked());
 		}
 
 		// Refresh settings
@@ -131,12 +137,30 @@ namespace PixelMaestroStudio {
 		}
 	}
 
+	/**
+	 * Toggles the performance overlay.
+	 * @param checked If true, the overlay is shown over the Maestro.
+	 */
+	void MaestroControlWidget::on_performanceButton_toggled(bool checked) {
+		UIUtility::highlight_widget(ui->performanceButton, checked);
+		if (checked) {
+			if (performance_overlay_.isNull() && maestro_drawing_area_ != nullptr) {
+				performance_overlay_ = new PerformanceOverlay(maestro_drawing_area_, *maestro_controller_);
+				performance_overlay_->show();
+			}
+		}
+		else {
+			delete performance_overlay_;
+		}
+	}
+
 	/**
 	 * Toggles whether the Maestro is running or paused.
 	 * @param checked If true, the Maestro is paused.
 	 */
 	void MaestroControlWidget::on_playPauseButton_toggled(bool checked) {
 		UIUtility::highlight_widget(ui->playPauseButton, checked);
+		ui->stepButton->setEnabled(checked);
 		if (checked) { // Stop the Maestro
 			maestro_controller_->stop();
 			run_cue(
@@ -166,6 +190,13 @@ namespace PixelMaestroStudio {
 		set_refresh_needed(false);
 	}
 
+	/**
+	 * Advances the paused Maestro by one refresh interval.
+	 */
+	void MaestroControlWidget::on_stepButton_clicked() {
+		maestro_controller_->advance(maestro_controller_->get_update_interval(), maestro_controller_->get_update_interval());
+	}
+
 	void MaestroControlWidget::on_syncButton_clicked() {
 		QMessageBox::StandardButton confirm;
 		confirm = QMessageBox::question(this, "Sync Timers", "This will sync all timers to the Maestro's current time, which might interrupt Animations, Shows, and Canvases. Are you sure you want to continue?", QMessageBox::Yes | QMessageBox::No);
@@ -203,12 +234,14 @@ namespace PixelMaestroStudio {
 	 * @param run_targets Bitmask of RunTargets specifying where to run the Cue.
 	 */
 	void MaestroControlWidget::run_cue(uint8_t *cue, int run_targets) {
+		TraceRecorder::Span span("MaestroControlWidget::run_cue");
 		show_control_widget_->add_event_to_history(cue);
 
 		// Only run the Cue if the Maestro isn't locked, or the Cue is a Show Cue.
 		if (!show_control_widget_->get_maestro_locked() || cue[(uint8_t)CueController::Byte::PayloadByte] == (uint8_t)CueController::Handler::ShowCueHandler) {
 			if ((run_targets & RunTarget::Local) == RunTarget::Local) {
-				cue_controller_->run(cue);
+				PerformanceMonitor::Scope scope(PerformanceMonitor::Stage::RunCue);
+				maestro_controller_->run_cue(cue);
 				set_maestro_modified(true);
 			}
 
@@ -248,6 +281,7 @@ namespace PixelMaestroStudio {
 		ui->playPauseButton->blockSignals(true);
 		ui->playPauseButton->setChecked(!maestro_controller.get_running());
 		ui->playPauseButton->blockSignals(false);
+		ui->stepButton->setEnabled(!maestro_controller.get_running());
 
 		// Initialize UI components and controllers
 		section_control_widget_->set_active_section(maestro_controller_->get_maestro().get_section(0));
@@ -266,6 +300,9 @@ namespace PixelMaestroStudio {
 	 */
 	void MaestroControlWidget::set_maestro_modified(bool modified) {
 		this->modified_ = modified;
+		if (modified) {
+			modification_count_++;
+		}
 
 		// Update MainWindow title
 		this->parentWidget()->parentWidget()->setWindowModified(modified);
@@ -290,6 +327,7 @@ namespace PixelMaestroStudio {
 			ui->renderLayout->insertWidget(0, maestro_drawing_area_);
 			maestro_controller_->add_drawing_area(*dynamic_cast<MaestroDrawingArea*>(maestro_drawing_area_));
 			dynamic_cast<MaestroDrawingArea*>(maestro_drawing_area_)->set_maestro_control_widget(this);
+			on_performanceButton_toggled(ui->performanceButton->isChecked());
 		}
 		else {
 			// Unchecked
@@ -9,6 +9,7 @@
 #include <QButtonGroup>
 #include <QColor>
 #include <QLocale>
+#include <QPointer>
 #include <QSerialPort>
 #include <QSharedPointer>
 #include <QTimer>
@@ -29,6 +30,7 @@
 #include "widget/devicecontrolwidget.h"
 #include "widget/animationcontrolwidget.h"
 #include "widget/canvascontrolwidget.h"
+#include "widget/performanceoverlay.h"
 #include "widget/sectioncontrolwidget.h"
 #include "widget/showcontrolwidget.h"
 
@@ -73,6 +75,7 @@ namespace PixelMaestroStudio {
 			explicit MaestroControlWidget(QWidget* parent);
 			~MaestroControlWidget();
 			bool get_maestro_modified() const;
+			uint32_t get_modification_count() const;
 			void edit_palettes(QString palette);
 			MaestroController* get_maestro_controller();
 			void load_cuefile(const QByteArray& byte_array);
@@ -86,6 +89,7 @@ namespace PixelMaestroStudio {
 
 		private slots:
 			void on_playPauseButton_toggled(bool checked);
+			void on_stepButton_clicked();
 
 			void on_syncButton_clicked();
 
@@ -93,6 +97,8 @@ namespace PixelMaestroStudio {
 
 			void on_refreshButton_clicked();
 
+			void on_performanceButton_toggled(bool checked);
+
 		private:
 			/// Bitmask determining where Cues are sent and executed.
 			enum RunTarget {
@@ -110,6 +116,12 @@ namespace PixelMaestroStudio {
 
 			/// Tracks whether the Maestro is currently modified.
 			bool modified_ = false;
+
+			/// The number of times the Maestro has been modified. Used to tell whether a save is still current once it finishes.
+			uint32_t modification_count_ = 0;
+
+			/// Frame rate and timing overlay. Only exists while enabled.
+			QPointer<PerformanceOverlay> performance_overlay_;
 	};
 }
 
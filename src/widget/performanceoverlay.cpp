@@ -0,0 +1,74 @@
+#include <QFontDatabase>
+#include "controller/maestrocontroller.h"
+#include "performanceoverlay.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * Turns on Stage timing for as long as the overlay exists.
+	 * @param parent Widget to draw the overlay on top of.
+	 * @param maestro_controller The controller whose Maestro is being measured.
+	 */
+	PerformanceOverlay::PerformanceOverlay(QWidget* parent, MaestroController& maestro_controller) : QLabel(parent), maestro_controller_(maestro_controller), refresh_timer_(this) {
+		this->setAttribute(Qt::WA_TransparentForMouseEvents);
+		this->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+		this->setStyleSheet("background-color: rgba(0, 0, 0, 160); color: white; padding: 4px;");
+		this->setTextFormat(Qt::PlainText);
+		this->move(8, 8);
+
+		for (uint8_t counter = 0; counter < static_cast<uint8_t>(PerformanceMonitor::Counter::NumCounters); counter++) {
+			last_counts_[counter] = PerformanceMonitor::get_count(static_cast<PerformanceMonitor::Counter>(counter));
+		}
+
+		PerformanceMonitor::set_enabled(true);
+		refresh_clock_.start();
+		connect(&refresh_timer_, SIGNAL(timeout()), this, SLOT(refresh()));
+		refresh_timer_.start(REFRESH_INTERVAL);
+		refresh();
+	}
+
+	/**
+	 * Updates the displayed statistics.
+	 * Rates are averaged over the time since the last refresh. Stage timings cover the most recent samples of each Stage.
+	 */
+	void PerformanceOverlay::refresh() {
+		double seconds = qMax<qint64>(refresh_clock_.restart(), 1) / 1000.0;
+
+		double rates[static_cast<uint8_t>(PerformanceMonitor::Counter::NumCounters)];
+		for (uint8_t counter = 0; counter < static_cast<uint8_t>(PerformanceMonitor::Counter::NumCounters); counter++) {
+			uint64_t count = PerformanceMonitor::get_count(static_cast<PerformanceMonitor::Counter>(counter));
+			rates[counter] = (count - last_counts_[counter]) / seconds;
+			last_counts_[counter] = count;
+		}
+
+		uint16_t interval = maestro_controller_.get_update_interval();
+		double target_fps = (interval > 0) ? 1000.0 / interval : 0;
+
+		QString text = QString("Simulated %1 / %2 fps\nPresented %3 fps\nMissed ticks %4\nCues %5/s\n")
+			.arg(rates[static_cast<uint8_t>(PerformanceMonitor::Counter::FramesSimulated)], 5, 'f', 1)
+			.arg(target_fps, 0, 'f', 1)
+			.arg(rates[static_cast<uint8_t>(PerformanceMonitor::Counter::FramesPresented)], 5, 'f', 1)
+			.arg(PerformanceMonitor::get_count(PerformanceMonitor::Counter::MissedTicks))
+			.arg(rates[static_cast<uint8_t>(PerformanceMonitor::Counter::CuesRun)], 0, 'f', 1);
+
+		text += QString("\n%1 %2 %3").arg("Stage (ms)", -12).arg("avg", 7).arg("p99", 7);
+		for (uint8_t stage = 0; stage < static_cast<uint8_t>(PerformanceMonitor::Stage::NumStages); stage++) {
+			PerformanceMonitor::StageStats stats = PerformanceMonitor::get_stats(static_cast<PerformanceMonitor::Stage>(stage));
+			text += QString("\n%1 ").arg(PerformanceMonitor::get_stage_name(static_cast<PerformanceMonitor::Stage>(stage)), -12);
+			if (stats.num_samples > 0) {
+				text += QString("%1 %2").arg(stats.average / 1000.0, 7, 'f', 2).arg(stats.p99 / 1000.0, 7, 'f', 2);
+			}
+			else {
+				text += QString("%1 %2").arg("-", 7).arg("-", 7);
+			}
+		}
+
+		this->setText(text);
+		this->adjustSize();
+		this->raise();
+	}
+
+	PerformanceOverlay::~PerformanceOverlay() {
+		PerformanceMonitor::set_enabled(false);
+	}
+}
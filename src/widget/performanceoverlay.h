@@ -0,0 +1,44 @@
+/*
+ * PerformanceOverlay - Displays frame rates and per-stage timings on top of a DrawingArea.
+ */
+
+#ifndef PERFORMANCEOVERLAY_H
+#define PERFORMANCEOVERLAY_H
+
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QTimer>
+#include "utility/performancemonitor.h"
+
+namespace PixelMaestroStudio {
+	class MaestroController;
+
+	class PerformanceOverlay : public QLabel {
+		Q_OBJECT
+
+		public:
+			PerformanceOverlay(QWidget* parent, MaestroController& maestro_controller);
+			~PerformanceOverlay();
+
+		private slots:
+			void refresh();
+
+		private:
+			/// How often the overlay is refreshed in milliseconds.
+			static const int REFRESH_INTERVAL = 500;
+
+			/// Counter values at the last refresh. Used to calculate rates.
+			uint64_t last_counts_[static_cast<uint8_t>(PerformanceMonitor::Counter::NumCounters)];
+
+			/// The controller whose Maestro is being measured.
+			MaestroController& maestro_controller_;
+
+			/// Time since the last refresh.
+			QElapsedTimer refresh_clock_;
+
+			/// Refreshes the overlay.
+			QTimer refresh_timer_;
+	};
+}
+
+#endif // PERFORMANCEOVERLAY_H
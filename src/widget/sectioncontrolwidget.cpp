@@ -1,3 +1,4 @@
+#include <QMutexLocker>
 #include "sectioncontrolwidget.h"
 #include "ui_sectioncontrolwidget.h"
 #include "utility/canvasutility.h"
@@ -12,11 +13,15 @@ namespace PixelMaestroStudio {
 
 	void SectionControlWidget::on_addLayerButton_clicked() {
 		// Get the number of Layers (and the index of the last Layer) in the Section
-		Section* base_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(get_section_index());
+		uint8_t section_index = get_section_index();
 		int num_layers = 0;
-		while (base_section->get_layer() != nullptr) {
-			base_section = base_section->get_layer()->section;
-			num_layers++;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			Section* base_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(section_index);
+			while (base_section->get_layer() != nullptr) {
+				base_section = base_section->get_layer()->section;
+				num_layers++;
+			}
 		}
 		uint8_t layer_index = ui->layerListWidget->count() - 1;
 
@@ -74,6 +79,7 @@ namespace PixelMaestroStudio {
 	 * @return Number of Layers.
 	 */
 	uint8_t SectionControlWidget::get_num_layers(Section& section) {
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
 		uint8_t count = 0;
 		Section::Layer* layer = section.get_layer();
 		while (layer != nullptr) {
@@ -105,6 +111,7 @@ namespace PixelMaestroStudio {
 		}
 
 		// Iterate until we find the Section that active_section_ points to
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
 		uint8_t index = 0;
 		Section* test_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(0);
 		while (test_section != target_section) {
@@ -123,12 +130,17 @@ namespace PixelMaestroStudio {
 		// Build Section list
 		ui->sectionListWidget->blockSignals(true);
 		ui->sectionListWidget->clear();
-		for (uint16_t section = 0; section < maestro_control_widget_.get_maestro_controller()->get_maestro().get_num_sections(); section++) {
-			ui->sectionListWidget->addItem(QString("Section ") + QString::number(section + 1));
+		Section* first_section;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			for (uint16_t section = 0; section < maestro_control_widget_.get_maestro_controller()->get_maestro().get_num_sections(); section++) {
+				ui->sectionListWidget->addItem(QString("Section ") + QString::number(section + 1));
+			}
+			first_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(0);
 		}
 		ui->sectionListWidget->blockSignals(false);
 
-		set_active_section(maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(0));
+		set_active_section(first_section);
 		populate_layer_combobox();
 	}
 
@@ -136,11 +148,17 @@ namespace PixelMaestroStudio {
 	 * Sets the Layer's transparency level.
 	 */
 	void SectionControlWidget::on_alphaSpinBox_editingFinished() {
+		Colors::MixMode mix_mode;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			mix_mode = active_section_->get_parent_section()->get_layer()->mix_mode;
+		}
+
 		maestro_control_widget_.run_cue(
 			maestro_control_widget_.section_handler->set_layer(
 				get_section_index(),
 				get_layer_index(*active_section_->get_parent_section()),
-				active_section_->get_parent_section()->get_layer()->mix_mode,
+				mix_mode,
 				ui->alphaSpinBox->value()
 			)
 		);
@@ -194,9 +212,14 @@ namespace PixelMaestroStudio {
 		 * If we selected an Layer, iterate through the Section's nested Layers until we find it.
 		 * If we selected 'None', use the base Section as the active Section.
 		 */
-		Section* layer_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(get_section_index());
-		for (int i = 0; i < currentRow; i++) {
-			layer_section = layer_section->get_layer()->section;
+		uint8_t section_index = get_section_index();
+		Section* layer_section;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			layer_section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(section_index);
+			for (int i = 0; i < currentRow; i++) {
+				layer_section = layer_section->get_layer()->section;
+			}
 		}
 
 		// Show Layer controls
@@ -236,7 +259,13 @@ namespace PixelMaestroStudio {
 		// Only continue if the active Section is a Layer.
 		if (get_layer_index() == 0) return ;
 
-		if ((Colors::MixMode)index != active_section_->get_parent_section()->get_layer()->mix_mode) {
+		Colors::MixMode mix_mode;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			mix_mode = active_section_->get_parent_section()->get_layer()->mix_mode;
+		}
+
+		if ((Colors::MixMode)index != mix_mode) {
 			maestro_control_widget_.run_cue(
 				maestro_control_widget_.section_handler->set_layer(
 					get_section_index(),
@@ -296,7 +325,12 @@ namespace PixelMaestroStudio {
 	void SectionControlWidget::on_sectionListWidget_currentRowChanged(int currentRow) {
 		set_layer_controls_enabled(false);
 
-		set_active_section(maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(currentRow));
+		Section* section;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			section = maestro_control_widget_.get_maestro_controller()->get_maestro().get_section(currentRow);
+		}
+		set_active_section(section);
 	}
 
 	void SectionControlWidget::on_wrapCheckBox_stateChanged(int arg1) {
@@ -318,6 +352,9 @@ namespace PixelMaestroStudio {
 			populate_layer_combobox();
 		}
 
+		// The widgets below have their signals blocked, so no Cues run while the Maestro is locked
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+
 		// Set dimensions
 		ui->gridSizeXSpinBox->blockSignals(true);
 		ui->gridSizeYSpinBox->blockSignals(true);
@@ -499,6 +536,7 @@ namespace PixelMaestroStudio {
 		ui->offsetXSpinBox->setEnabled(new_x == 0);
 		ui->offsetYSpinBox->setEnabled(new_y == 0);
 
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
 		if (new_x == 0) {
 			ui->offsetXSpinBox->blockSignals(true);
 			ui->offsetXSpinBox->setValue(active_section_->get_offset().x);
@@ -2,6 +2,7 @@
 #include <QListIterator>
 #include <QListWidget>
 #include <QModelIndex>
+#include <QMutexLocker>
 #include <QRegExp>
 #include <QSettings>
 #include <QTime>
@@ -307,6 +308,8 @@ namespace PixelMaestroStudio {
 	 * Updates the UI in the event of a Maestro change.
 	 */
 	void ShowControlWidget::refresh() {
+		// The widgets below have their signals blocked, so no Cues run while the Maestro is locked
+		QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
 		Show* show = maestro_control_widget_.get_maestro_controller()->get_maestro().get_show();
 		ui->enableCheckBox->blockSignals(true);
 		ui->enableCheckBox->setChecked(show != nullptr);
@@ -375,22 +378,39 @@ namespace PixelMaestroStudio {
 		uint absolute_time = (uint)maestro_control_widget_.get_maestro_controller()->get_total_elapsed_time();
 		ui->absoluteTimeLineEdit->setText(QTime::fromMSecsSinceStartOfDay(absolute_time).toString(time_format));
 
-		Show* show = maestro_control_widget_.get_maestro_controller()->get_maestro().get_show();
-		if (show == nullptr) return;
+		// Copy what we need from the Show so the Maestro isn't locked while the UI updates
+		Show::TimingMode timing;
+		uint32_t last_time;
+		uint16_t current_index;
+		QByteArray current_cue;
+		{
+			QMutexLocker locker(maestro_control_widget_.get_maestro_controller()->get_maestro_mutex());
+			Show* show = maestro_control_widget_.get_maestro_controller()->get_maestro().get_show();
+			if (show == nullptr) return;
+
+			timing = show->get_timing();
+			last_time = show->get_last_time();
+			current_index = show->get_current_index();
+			Event* event = show->get_event_at_index(current_index);
+			if (event != nullptr) {
+				CueController& cue_controller = maestro_control_widget_.get_maestro_controller()->get_maestro().get_cue_controller();
+				current_cue = QByteArray(reinterpret_cast<const char*>(event->get_cue()), cue_controller.get_cue_size(event->get_cue()));
+			}
+		}
 
 		// If relative mode is enabled, calculate the time since the last Event
-		if (show->get_timing() == Show::TimingMode::Relative) {
-			uint relative_time = absolute_time - show->get_last_time();
+		if (timing == Show::TimingMode::Relative) {
+			uint relative_time = absolute_time - last_time;
 			ui->relativeTimeLineEdit->setText(QTime::fromMSecsSinceStartOfDay(relative_time).toString(time_format));
 		}
 
 		// Get the last event that ran, and if it differs from the Show's current index, update the Event Queue
-		if (last_event_time_ != show->get_last_time()) {
-			last_event_time_ = show->get_last_time();
+		if (last_event_time_ != last_time) {
+			last_event_time_ = last_time;
 
 			// Darken events that have already ran
 			for (int i = 0; i < ui->eventQueueWidget->count(); i++) {
-				if (i < show->get_current_index()) {
+				if (i < current_index) {
 					ui->eventQueueWidget->item(i)->setTextColor(Qt::GlobalColor::darkGray);
 				}
 				else {
@@ -401,12 +421,10 @@ namespace PixelMaestroStudio {
 			// If live update triggers are enabled, send the last Event's queue to the DeviceControlWidget to be sent to remote devices
 			QSettings settings;
 			if (settings.value(PreferencesDialog::events_trigger_device_updates, false).toBool()) {
-				Event* event = show->get_event_at_index(show->get_current_index());
-				if (event != nullptr) {
-					CueController* cue_controller = &maestro_control_widget_.get_maestro_controller()->get_maestro().get_cue_controller();
+				if (!current_cue.isEmpty()) {
 					maestro_control_widget_.device_control_widget_->run_cue(
-						event->get_cue(),
-						cue_controller->get_cue_size(event->get_cue())
+						reinterpret_cast<uint8_t*>(current_cue.data()),
+						current_cue.size()
 					);
 				}
 			}
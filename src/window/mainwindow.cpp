@@ -1,6 +1,7 @@
 #include <QDate>
 #include <QDesktopServices>
 #include <QFileDialog>
+#include <QFutureWatcher>
 #include <QMessageBox>
 #include <QSettings>
 #include <QStandardPaths>
@@ -8,6 +9,7 @@
 #include "dialog/preferencesdialog.h"
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
+#include "utility/tracerecorder.h"
 
 namespace PixelMaestroStudio {
 
@@ -38,6 +40,8 @@ namespace PixelMaestroStudio {
 
 		set_active_cuefile("");
 
+		start_metrics_server();
+
 		initialization_complete = true;
 	}
 
@@ -172,7 +176,9 @@ namespace PixelMaestroStudio {
 	 */
 	void MainWindow::on_preferencesAction_triggered() {
 		PreferencesDialog preferences;
-		preferences.exec();
+		if (preferences.exec() == QDialog::Accepted) {
+			start_metrics_server();
+		}
 	}
 
 	/**
@@ -187,6 +193,44 @@ namespace PixelMaestroStudio {
 		}
 	}
 
+	/**
+	 * Starts or stops recording a trace.
+	 * Starting a new recording discards the previous one.
+	 * @param checked If true, start recording.
+	 */
+	void MainWindow::on_recordTraceAction_toggled(bool checked) {
+		if (checked) {
+			TraceRecorder::clear();
+			TraceRecorder::set_thread_name("GUI");
+		}
+		TraceRecorder::set_enabled(checked);
+	}
+
+	/**
+	 * Saves the recorded trace as Chrome trace event JSON.
+	 */
+	void MainWindow::on_saveTraceAction_triggered() {
+		QString filename = QFileDialog::getSaveFileName(this,
+			QString("Save Trace"),
+			QDir::home().path(),
+			QString("Trace File (*.json)"));
+
+		if (!filename.isEmpty()) {
+			if (!filename.endsWith(".json", Qt::CaseInsensitive)) {
+				filename.append(".json");
+			}
+
+			QFile file(filename);
+			if (file.open(QFile::WriteOnly)) {
+				file.write(TraceRecorder::to_json());
+				file.close();
+			}
+			else {
+				QMessageBox::warning(this, QString("Save Trace"), QString("Unable to write to ") + filename);
+			}
+		}
+	}
+
 	/**
 	 * Saves the currently loaded Cuefile.
 	 */
@@ -195,13 +239,13 @@ namespace PixelMaestroStudio {
 			on_saveAsAction_triggered();
 		}
 		else {
-			QFile file(this->loaded_cuefile_path_);
-			if (file.open(QFile::WriteOnly)) {
-				QDataStream datastream(&file);
-				this->maestro_controller_->save_maestro_to_datastream(datastream);
-				file.close();
-				setWindowModified(false);
-			}
+			// Build the Cuefile in the background, then write it out once it's ready
+			QFutureWatcher<QByteArray>* watcher = new QFutureWatcher<QByteArray>(this);
+			pending_saves_.insert(watcher, { this->loaded_cuefile_path_, maestro_control_widget_->get_modification_count() });
+			connect(watcher, &QFutureWatcher<QByteArray>::finished, this, [this, watcher]() {
+				write_cuefile(watcher);
+			});
+			watcher->setFuture(this->maestro_controller_->get_cuefile_cache().generate());
 		}
 	}
 
@@ -297,15 +341,54 @@ namespace PixelMaestroStudio {
 		}
 	}
 
+	/**
+	 * Starts or stops the metrics server to match the user's settings.
+	 */
+	void MainWindow::start_metrics_server() {
+		if (metrics_server_ == nullptr) {
+			metrics_server_ = new MetricsServer(this, *maestro_control_widget_->device_control_widget_);
+		}
+
+		if (!metrics_server_->apply_settings()) {
+			QMessageBox::warning(this, QString("Metrics Server"), QString("Unable to serve metrics: ") + metrics_server_->get_error());
+		}
+	}
+
+	/**
+	 * Writes a Cuefile that finished building in the background.
+	 * The window is only marked as saved if the Maestro hasn't changed since the Cuefile was generated.
+	 * @param watcher Watcher holding the Cuefile.
+	 */
+	void MainWindow::write_cuefile(QFutureWatcher<QByteArray>* watcher) {
+		if (!pending_saves_.contains(watcher)) return;
+
+		PendingSave save = pending_saves_.take(watcher);
+		QFile file(save.path);
+		if (file.open(QFile::WriteOnly)) {
+			file.write(watcher->result());
+			file.close();
+			if (maestro_control_widget_->get_modification_count() == save.modification_count) {
+				setWindowModified(false);
+			}
+		}
+		else {
+			QMessageBox::warning(this, QString("Save Cue File"), QString("Unable to write to ") + save.path);
+		}
+		watcher->deleteLater();
+	}
+
 	MainWindow::~MainWindow() {
+		// Finish any saves that are still running, since their watchers are destroyed along with the window
+		for (QFutureWatcher<QByteArray>* watcher : pending_saves_.keys()) {
+			watcher->waitForFinished();
+			write_cuefile(watcher);
+		}
+
 		QSettings settings;
 
 		// If session saving on close is enabled, save the session
 		if (settings.value(PreferencesDialog::save_session, true).toBool()) {
-			QByteArray maestro_config;
-			QDataStream maestro_datastream(&maestro_config, QIODevice::Truncate);
-			maestro_controller_->save_maestro_to_datastream(maestro_datastream);
-			settings.setValue(PreferencesDialog::last_session, maestro_config);
+			settings.setValue(PreferencesDialog::last_session, maestro_controller_->get_cuefile_cache().get_cuefile());
 			settings.setValue(PreferencesDialog::separate_window_option, ui->action_Secondary_Window->isChecked());
 			settings.setValue(PreferencesDialog::main_window_option, ui->action_Main_Window->isChecked());
 		}
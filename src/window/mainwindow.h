@@ -2,8 +2,11 @@
 #define MAINWINDOW_H
 
 #include "../controller/maestrocontroller.h"
+#include "../controller/metricsserver.h"
 #include "../widget/maestrocontrolwidget.h"
 #include <QByteArray>
+#include <QFutureWatcher>
+#include <QHash>
 #include <QMainWindow>
 #include <QStandardPaths>
 #include <QString>
@@ -33,11 +36,23 @@ namespace PixelMaestroStudio {
 
 			void on_queueAction_triggered();
 
+			void on_recordTraceAction_toggled(bool checked);
+			void on_saveTraceAction_triggered();
+
 			void on_action_Main_Window_toggled(bool arg1);
 
 			void on_action_Secondary_Window_toggled(bool arg1);
 
 		private:
+			/// A Cuefile that's being built in the background.
+			struct PendingSave {
+				/// Where to write the Cuefile.
+				QString path;
+
+				/// The Maestro's modification count when the Cuefile was generated.
+				uint32_t modification_count = 0;
+			};
+
 			/// Whether the application has completed initialization.
 			bool initialization_complete = false;
 
@@ -51,13 +66,21 @@ namespace PixelMaestroStudio {
 			/// The widget responsible for modifying the Maestro.
 			MaestroControlWidget* maestro_control_widget_ = nullptr;
 
+			/// Serves performance counters to local monitoring tools.
+			MetricsServer* metrics_server_ = nullptr;
+
+			/// Cuefiles that are still being built, keyed by the watcher waiting on each one.
+			QHash<QFutureWatcher<QByteArray>*, PendingSave> pending_saves_;
+
 			Ui::MainWindow* ui;
 
 			void initialize_widgets();
 			bool open_cuefile(const QString& filename);
 			bool confirm_unsaved_changes();
 			void set_active_cuefile(const QString& path);
+			void start_metrics_server();
 			QString open_cuefile_dialog();
+			void write_cuefile(QFutureWatcher<QByteArray>* watcher);
 	};
 }
 
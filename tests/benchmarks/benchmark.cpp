@@ -0,0 +1,71 @@
+#include <algorithm>
+#include <QtGlobal>
+#include "benchmark.h"
+
+namespace PixelMaestroStudio {
+	/**
+	 * Constructor.
+	 * @param min_time The minimum amount of time to spend timing each benchmark in milliseconds.
+	 * @param filter Only run benchmarks whose names contain this string. Leave blank to run all benchmarks.
+	 */
+	Benchmark::Benchmark(int min_time, const QString& filter) : filter_(filter), min_time_(min_time) { }
+
+	/**
+	 * Calculates statistics for a benchmark and adds them to the results.
+	 * @param name Benchmark name.
+	 * @param params Parameters that the benchmark was run with.
+	 * @param ops_per_iteration The number of operations performed in each iteration.
+	 * @param samples Time taken by each iteration in nanoseconds. Gets sorted.
+	 */
+	void Benchmark::add_result(const QString& name, const QJsonObject& params, uint32_t ops_per_iteration, QVector<qint64>& samples) {
+		std::sort(samples.begin(), samples.end());
+
+		double total = 0;
+		for (qint64 sample : samples) {
+			total += sample;
+		}
+
+		// Nearest-rank percentile, scaled to a single operation
+		double ops = qMax<uint32_t>(ops_per_iteration, 1);
+		auto percentile = [&samples, ops](double percent) {
+			int rank = qBound(1, static_cast<int>(percent / 100.0 * samples.size() + 0.5), samples.size());
+			return samples[rank - 1] / ops;
+		};
+
+		QJsonObject ns_per_op;
+		ns_per_op["mean"] = total / samples.size() / ops;
+		ns_per_op["min"] = samples.first() / ops;
+		ns_per_op["median"] = percentile(50);
+		ns_per_op["p90"] = percentile(90);
+		ns_per_op["p99"] = percentile(99);
+		ns_per_op["max"] = samples.last() / ops;
+
+		QJsonObject result;
+		result["name"] = name;
+		result["params"] = params;
+		result["iterations"] = samples.size();
+		result["ops_per_iteration"] = static_cast<int>(ops_per_iteration);
+		result["ns_per_op"] = ns_per_op;
+		results_.append(result);
+	}
+
+	/**
+	 * Returns the results of every benchmark run so far.
+	 * @return Results document.
+	 */
+	QJsonDocument Benchmark::get_results() const {
+		QJsonObject root;
+		root["version"] = QString(BUILD_VERSION);
+		root["benchmarks"] = results_;
+		return QJsonDocument(root);
+	}
+
+	/**
+	 * Checks whether a benchmark passes the filter.
+	 * @param name Benchmark name.
+	 * @return True if the benchmark should run.
+	 */
+	bool Benchmark::is_enabled(const QString& name) const {
+		return filter_.isEmpty() || name.contains(filter_);
+	}
+}
@@ -0,0 +1,74 @@
+/*
+ * Benchmark - Times a piece of code over many iterations and collects the results as JSON.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+namespace PixelMaestroStudio {
+	class Benchmark {
+		public:
+			Benchmark(int min_time, const QString& filter);
+			QJsonDocument get_results() const;
+			bool is_enabled(const QString& name) const;
+
+			/**
+			 * Runs a benchmark and records its timings.
+			 * The function is run a few times to warm up, then repeatedly until the minimum run time has passed.
+			 * @param name Benchmark name.
+			 * @param params Parameters that the benchmark was run with.
+			 * @param ops_per_iteration The number of operations performed by each call to the function. Used to report the time per operation.
+			 * @param iteration Function to time.
+			 */
+			template<typename Function>
+			void run(const QString& name, const QJsonObject& params, uint32_t ops_per_iteration, Function iteration) {
+				if (!is_enabled(name)) return;
+
+				for (int i = 0; i < WARMUP_ITERATIONS; i++) {
+					iteration();
+				}
+
+				QVector<qint64> samples;
+				QElapsedTimer total;
+				QElapsedTimer timer;
+				total.start();
+				while (samples.size() < MIN_ITERATIONS || (total.elapsed() < min_time_ && samples.size() < MAX_ITERATIONS)) {
+					timer.start();
+					iteration();
+					samples.append(timer.nsecsElapsed());
+				}
+
+				add_result(name, params, ops_per_iteration, samples);
+			}
+
+		private:
+			/// The number of untimed iterations run before measuring.
+			static const int WARMUP_ITERATIONS = 10;
+
+			/// The maximum number of timed iterations.
+			static const int MAX_ITERATIONS = 1000000;
+
+			/// The minimum number of timed iterations.
+			static const int MIN_ITERATIONS = 20;
+
+			/// Only benchmarks whose names contain this string are run.
+			QString filter_;
+
+			/// The minimum amount of time to spend timing each benchmark in milliseconds.
+			int min_time_;
+
+			/// Results of each benchmark run so far.
+			QJsonArray results_;
+
+			void add_result(const QString& name, const QJsonObject& params, uint32_t ops_per_iteration, QVector<qint64>& samples);
+	};
+}
+
+#endif // BENCHMARK_H
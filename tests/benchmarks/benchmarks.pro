@@ -0,0 +1,102 @@
+#-------------------------------------------------
+#
+# Benchmarks for the core library. Prints results as JSON.
+#
+#-------------------------------------------------
+
+QT       += core gui concurrent
+
+TARGET = PixelMaestro_Benchmarks
+CONFIG   += console
+CONFIG   -= app_bundle
+TEMPLATE = app
+DEFINES += BUILD_VERSION=\\\"v0.60.0\\\" PIXEL_ENABLE_ACCURATE_FADING CANVAS_ENABLE_FONTS
+QMAKE_CXXFLAGS = -std=c++11 -Wall -Wno-unused-parameter -Wno-reorder -Wno-switch
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+SOURCES += main.cpp \
+benchmark.cpp \
+../../src/controller/idlescheduler.cpp \
+../../src/controller/sectioncompositor.cpp \
+../../src/controller/sectionupdater.cpp \
+../../src/utility/performancemonitor.cpp \
+../../lib/PixelMaestro/src/canvas/fonts/font5x8.cpp \
+../../lib/PixelMaestro/src/animation/blinkanimation.cpp \
+../../lib/PixelMaestro/src/animation/cycleanimation.cpp \
+../../lib/PixelMaestro/src/animation/randomanimation.cpp \
+../../lib/PixelMaestro/src/animation/solidanimation.cpp \
+../../lib/PixelMaestro/src/animation/sparkleanimation.cpp \
+../../lib/PixelMaestro/src/animation/waveanimation.cpp \
+../../lib/PixelMaestro/src/animation/animation.cpp \
+../../lib/PixelMaestro/src/core/colors.cpp \
+../../lib/PixelMaestro/src/core/maestro.cpp \
+../../lib/PixelMaestro/src/core/pixel.cpp \
+../../lib/PixelMaestro/src/core/point.cpp \
+../../lib/PixelMaestro/src/core/section.cpp \
+../../lib/PixelMaestro/src/utility.cpp \
+../../lib/PixelMaestro/src/animation/radialanimation.cpp \
+../../lib/PixelMaestro/src/animation/mandelbrotanimation.cpp \
+../../lib/PixelMaestro/src/animation/plasmaanimation.cpp \
+../../lib/PixelMaestro/src/animation/lightninganimation.cpp \
+../../lib/PixelMaestro/src/canvas/canvas.cpp \
+../../lib/PixelMaestro/src/cue/event.cpp \
+../../lib/PixelMaestro/src/cue/show.cpp \
+../../lib/PixelMaestro/src/cue/cuecontroller.cpp \
+../../lib/PixelMaestro/src/cue/animationcuehandler.cpp \
+../../lib/PixelMaestro/src/cue/canvascuehandler.cpp \
+../../lib/PixelMaestro/src/cue/maestrocuehandler.cpp \
+../../lib/PixelMaestro/src/cue/sectioncuehandler.cpp \
+../../lib/PixelMaestro/src/colorpresets.cpp \
+../../lib/PixelMaestro/src/cue/cuehandler.cpp \
+../../lib/PixelMaestro/src/cue/showcuehandler.cpp \
+../../lib/PixelMaestro/src/animation/fireanimation.cpp \
+../../lib/PixelMaestro/src/core/timer/timer.cpp \
+../../lib/PixelMaestro/src/core/timer/animationtimer.cpp \
+../../lib/PixelMaestro/src/core/palette.cpp
+
+HEADERS += ../../src/controller/idlescheduler.h \
+../../src/controller/sectioncompositor.h \
+../../src/controller/sectionupdater.h \
+../../src/utility/performancemonitor.h \
+../../src/utility/cuefileutility.h \
+benchmark.h \
+../../lib/PixelMaestro/src/canvas/fonts/font.h \
+../../lib/PixelMaestro/src/canvas/fonts/font5x8.h \
+../../lib/PixelMaestro/src/animation/blinkanimation.h \
+../../lib/PixelMaestro/src/animation/cycleanimation.h \
+../../lib/PixelMaestro/src/animation/randomanimation.h \
+../../lib/PixelMaestro/src/animation/solidanimation.h \
+../../lib/PixelMaestro/src/animation/sparkleanimation.h \
+../../lib/PixelMaestro/src/animation/waveanimation.h \
+../../lib/PixelMaestro/src/animation/animation.h \
+../../lib/PixelMaestro/src/animation/animationtype.h \
+../../lib/PixelMaestro/src/core/colors.h \
+../../lib/PixelMaestro/src/core/maestro.h \
+../../lib/PixelMaestro/src/core/pixel.h \
+../../lib/PixelMaestro/src/core/point.h \
+../../lib/PixelMaestro/src/core/section.h \
+../../lib/PixelMaestro/src/utility.h \
+../../lib/PixelMaestro/src/animation/radialanimation.h \
+../../lib/PixelMaestro/src/animation/mandelbrotanimation.h \
+../../lib/PixelMaestro/src/animation/plasmaanimation.h \
+../../lib/PixelMaestro/src/animation/lightninganimation.h \
+../../lib/PixelMaestro/src/canvas/canvas.h \
+../../lib/PixelMaestro/src/cue/event.h \
+../../lib/PixelMaestro/src/cue/show.h \
+../../lib/PixelMaestro/src/cue/cuecontroller.h \
+../../lib/PixelMaestro/src/cue/cuehandler.h \
+../../lib/PixelMaestro/src/cue/animationcuehandler.h \
+../../lib/PixelMaestro/src/cue/canvascuehandler.h \
+../../lib/PixelMaestro/src/cue/maestrocuehandler.h \
+../../lib/PixelMaestro/src/cue/sectioncuehandler.h \
+../../lib/PixelMaestro/src/colorpresets.h \
+../../lib/PixelMaestro/src/cue/showcuehandler.h \
+../../lib/PixelMaestro/src/animation/fireanimation.h \
+../../lib/PixelMaestro/src/core/timer/timer.h \
+../../lib/PixelMaestro/src/core/timer/animationtimer.h \
+../../lib/PixelMaestro/src/core/palette.h
+
+INCLUDEPATH += \
+$$PWD/../../src \
+$$PWD/../../lib/PixelMaestro/src
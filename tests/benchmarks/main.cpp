@@ -0,0 +1,363 @@
+/*
+ * PixelMaestro Benchmarks - Times the parts of the core library that PixelMaestro Studio relies on and prints the results as JSON.
+ *
+ * Usage: PixelMaestro_Benchmarks [--grid 10,32,64] [--layers 1,2,4] [--sections 1,4,16] [--min-time ms] [--filter name] [--output file]
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+#include <memory>
+#include "animation/animationtype.h"
+#include "benchmark.h"
+#include "canvas/canvas.h"
+#include "colorpresets.h"
+#include "controller/sectioncompositor.h"
+#include "controller/sectionupdater.h"
+#include "core/colors.h"
+#include "core/maestro.h"
+#include "core/palette.h"
+#include "core/section.h"
+#include "cue/animationcuehandler.h"
+#include "cue/sectioncuehandler.h"
+#include "utility/cuefileutility.h"
+
+using namespace PixelMaestro;
+using namespace PixelMaestroStudio;
+
+/// Names of each AnimationType, in enum order.
+static const char* ANIMATION_NAMES[] = { "Blink", "Cycle", "Fire", "Lightning", "Mandelbrot", "Plasma", "Radial", "Random", "Solid", "Sparkle", "Wave" };
+
+/// Names of each MixMode, in enum order.
+static const char* MIX_MODE_NAMES[] = { "None", "Alpha", "Multiply", "Overlay" };
+
+/// A Maestro set up the same way as in PixelMaestro Studio. Owns its Sections.
+class Scene {
+	private:
+		/// Sections belonging to the Maestro. Declared first so that they outlive the Maestro.
+		std::unique_ptr<Section[]> sections_;
+
+	public:
+		/**
+		 * Constructor.
+		 * @param num_sections The number of Sections to create.
+		 * @param width Width of each Section.
+		 * @param height Height of each Section.
+		 */
+		Scene(uint8_t num_sections, uint16_t width, uint16_t height) : sections_(new Section[num_sections]), maestro(nullptr, 0) {
+			for (uint8_t section = 0; section < num_sections; section++) {
+				sections_[section].set_dimensions(width, height);
+			}
+			maestro.set_sections(sections_.get(), num_sections);
+			CuefileUtility::initialize_cue_controller(maestro);
+		}
+
+		/**
+		 * Adds Layers and Animations to every Section using Cues.
+		 * @param num_layers The total number of Layers per Section, including the Section itself.
+		 * @param type The Animation to run on each Layer.
+		 * @param mix_mode How each Layer is mixed with the Layer below it.
+		 * @param cues If set, each Cue is also appended here.
+		 */
+		void animate(uint8_t num_layers, AnimationType type, Colors::MixMode mix_mode, QByteArray* cues = nullptr) {
+			CueController& controller = maestro.get_cue_controller();
+			SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+			AnimationCueHandler* animation_handler = dynamic_cast<AnimationCueHandler*>(controller.get_handler(CueController::Handler::AnimationCueHandler));
+
+			for (uint8_t section = 0; section < maestro.get_num_sections(); section++) {
+				for (uint8_t layer = 0; layer < num_layers; layer++) {
+					if (layer + 1 < num_layers) {
+						run(section_handler->set_layer(section, layer, mix_mode, 128), cues);
+					}
+					run(section_handler->set_animation(section, layer, type, false), cues);
+					run(animation_handler->set_palette(section, layer, palette_), cues);
+				}
+			}
+		}
+
+		/// The Maestro being benchmarked.
+		Maestro maestro;
+
+	private:
+		/// Palette used by every Animation.
+		Palette palette_ = Palette(ColorPresets::Colorwheel, 12);
+
+		/**
+		 * Runs a Cue on the Maestro.
+		 * @param cue Cue to run.
+		 * @param cues If set, the Cue is also appended here.
+		 */
+		void run(uint8_t* cue, QByteArray* cues) {
+			CueController& controller = maestro.get_cue_controller();
+			if (cues != nullptr) {
+				cues->append(reinterpret_cast<const char*>(cue), static_cast<int>(controller.get_cue_size(cue)));
+			}
+			controller.run(cue);
+		}
+};
+
+/**
+ * Builds the parameter object shared by most benchmarks.
+ * @param grid Section width and height.
+ * @param layers The number of Layers per Section.
+ * @param sections The number of Sections.
+ * @return Parameters.
+ */
+static QJsonObject make_params(int grid, int layers, int sections) {
+	QJsonObject params;
+	params["grid"] = grid;
+	params["layers"] = layers;
+	params["sections"] = sections;
+	return params;
+}
+
+/**
+ * Parses a comma-separated list of positive numbers.
+ * @param value List to parse.
+ * @return Numbers in the list.
+ */
+static QVector<int> parse_list(const QString& value) {
+	QVector<int> list;
+	for (const QString& item : value.split(',', QString::SkipEmptyParts)) {
+		int number = item.trimmed().toInt();
+		if (number > 0) {
+			list.append(number);
+		}
+	}
+	return list;
+}
+
+/**
+ * Times Maestro::update() with every Section animated, both serially and with Sections updated in parallel.
+ */
+static void benchmark_maestro_update(Benchmark& benchmark, const QVector<int>& grids, const QVector<int>& layers, const QVector<int>& sections) {
+	for (int num_sections : sections) {
+		for (int grid : grids) {
+			for (int num_layers : layers) {
+				Scene scene(num_sections, grid, grid);
+				scene.animate(num_layers, AnimationType::Wave, Colors::MixMode::Alpha);
+
+				uint32_t time = 0;
+				benchmark.run("maestro_update", make_params(grid, num_layers, num_sections), 1, [&]() {
+					time += scene.maestro.get_timer().get_interval();
+					scene.maestro.update(time, true);
+				});
+
+				// Sections are only spread across threads when there's more than one
+				if (num_sections < 2) continue;
+
+				SectionUpdater updater;
+				updater.set_parallel(true);
+				benchmark.run("maestro_update_parallel", make_params(grid, num_layers, num_sections), 1, [&]() {
+					time += scene.maestro.get_timer().get_interval();
+					updater.update(scene.maestro, time, true);
+				});
+			}
+		}
+	}
+}
+
+/**
+ * Times reading every Pixel in a Section through Section::get_pixel_color(), which mixes each Layer into the final color, and through SectionCompositor, which mixes each row one Layer at a time.
+ */
+static void benchmark_get_pixel_color(Benchmark& benchmark, const QVector<int>& grids, const QVector<int>& layers) {
+	for (int mode = 0; mode < static_cast<int>(sizeof(MIX_MODE_NAMES) / sizeof(MIX_MODE_NAMES[0])); mode++) {
+		for (int grid : grids) {
+			for (int num_layers : layers) {
+				// Mix modes only apply when there's more than one Layer
+				if (num_layers == 1 && mode > 0) continue;
+
+				Scene scene(1, grid, grid);
+				scene.animate(num_layers, AnimationType::Wave, static_cast<Colors::MixMode>(mode));
+				scene.maestro.update(scene.maestro.get_timer().get_interval(), true);
+
+				Section& section = *scene.maestro.get_section(0);
+				QJsonObject params = make_params(grid, num_layers, 1);
+				params["mix_mode"] = MIX_MODE_NAMES[mode];
+
+				uint32_t checksum = 0;
+				benchmark.run("section_get_pixel_color", params, grid * grid, [&]() {
+					for (uint16_t y = 0; y < grid; y++) {
+						for (uint16_t x = 0; x < grid; x++) {
+							checksum += section.get_pixel_color(x, y).r;
+						}
+					}
+				});
+
+				SectionCompositor compositor;
+				QVector<QRgb> output(grid * grid);
+				benchmark.run("section_composite", params, grid * grid, [&]() {
+					compositor.composite(section, output.data());
+					checksum += output[0];
+				});
+
+				// Keep the compiler from discarding the loop
+				if (checksum == UINT32_MAX) QTextStream(stderr) << checksum;
+			}
+		}
+	}
+}
+
+/**
+ * Times a single frame of each AnimationType.
+ */
+static void benchmark_animations(Benchmark& benchmark, const QVector<int>& grids, const QVector<int>& layers) {
+	for (int type = 0; type < static_cast<int>(sizeof(ANIMATION_NAMES) / sizeof(ANIMATION_NAMES[0])); type++) {
+		for (int grid : grids) {
+			for (int num_layers : layers) {
+				Scene scene(1, grid, grid);
+				scene.animate(num_layers, static_cast<AnimationType>(type), Colors::MixMode::Alpha);
+
+				QJsonObject params = make_params(grid, num_layers, 1);
+				params["animation"] = ANIMATION_NAMES[type];
+
+				uint32_t time = 0;
+				benchmark.run("animation_update", params, 1, [&]() {
+					time += scene.maestro.get_timer().get_interval();
+					scene.maestro.update(time, true);
+				});
+			}
+		}
+	}
+}
+
+/**
+ * Times drawing a full frame into a Canvas.
+ */
+static void benchmark_canvas_draw_frame(Benchmark& benchmark, const QVector<int>& grids) {
+	for (int grid : grids) {
+		Scene scene(1, grid, grid);
+		CueController& controller = scene.maestro.get_cue_controller();
+		SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+		controller.run(section_handler->set_canvas(0, 0));
+
+		Canvas* canvas = scene.maestro.get_section(0)->get_canvas();
+		QVector<uint8_t> frame(grid * grid);
+		for (int i = 0; i < frame.size(); i++) {
+			frame[i] = static_cast<uint8_t>(i % 12);
+		}
+
+		benchmark.run("canvas_draw_frame", make_params(grid, 1, 1), 1, [&]() {
+			canvas->draw_frame(frame.data(), grid, grid);
+		});
+	}
+}
+
+/**
+ * Times parsing a Cuefile with CueController::read(), then running the parsed Cues with CueController::run().
+ */
+static void benchmark_cues(Benchmark& benchmark, const QVector<int>& grids, const QVector<int>& layers, const QVector<int>& sections) {
+	for (int num_sections : sections) {
+		for (int grid : grids) {
+			for (int num_layers : layers) {
+				QByteArray cuefile;
+				Scene source(num_sections, grid, grid);
+				source.animate(num_layers, AnimationType::Wave, Colors::MixMode::Alpha, &cuefile);
+
+				QVector<QByteArray> cues;
+				CuefileUtility::read_cuefile(cuefile, [&](uint8_t* cue) {
+					cues.append(QByteArray(reinterpret_cast<const char*>(cue), static_cast<int>(source.maestro.get_cue_controller().get_cue_size(cue))));
+				});
+
+				QJsonObject params = make_params(grid, num_layers, num_sections);
+				params["bytes"] = cuefile.size();
+
+				benchmark.run("cue_read", params, cues.size(), [&]() {
+					CuefileUtility::read_cuefile(cuefile, [](uint8_t*) { });
+				});
+
+				Scene target(num_sections, grid, grid);
+				benchmark.run("cue_run", params, cues.size(), [&]() {
+					for (QByteArray& cue : cues) {
+						target.maestro.get_cue_controller().run(reinterpret_cast<uint8_t*>(cue.data()));
+					}
+				});
+			}
+		}
+	}
+}
+
+/**
+ * Times Colors::mix_colors() with each MixMode.
+ */
+static void benchmark_mix_colors(Benchmark& benchmark) {
+	const int num_colors = 4096;
+	QVector<Colors::RGB> colors(num_colors);
+	for (int i = 0; i < num_colors; i++) {
+		colors[i] = Colors::RGB(static_cast<uint8_t>(i * 7), static_cast<uint8_t>(i * 13), static_cast<uint8_t>(i * 29));
+	}
+
+	for (int mode = 0; mode < static_cast<int>(sizeof(MIX_MODE_NAMES) / sizeof(MIX_MODE_NAMES[0])); mode++) {
+		QJsonObject params;
+		params["mix_mode"] = MIX_MODE_NAMES[mode];
+
+		uint32_t checksum = 0;
+		benchmark.run("colors_mix_colors", params, num_colors, [&]() {
+			for (int i = 0; i < num_colors; i++) {
+				checksum += Colors::mix_colors(colors[i], colors[num_colors - 1 - i], static_cast<Colors::MixMode>(mode), 128).g;
+			}
+		});
+
+		if (checksum == UINT32_MAX) QTextStream(stderr) << checksum;
+	}
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("PixelMaestro Benchmarks");
+	QCoreApplication::setApplicationVersion(BUILD_VERSION);
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Benchmarks the PixelMaestro core library and prints the results as JSON.");
+	parser.addHelpOption();
+	parser.addVersionOption();
+
+	QCommandLineOption grid_option("grid", "Comma-separated Section widths and heights (default: 10,32,64).", "sizes", "10,32,64");
+	QCommandLineOption layers_option("layers", "Comma-separated Layer counts (default: 1,2,4).", "counts", "1,2,4");
+	QCommandLineOption sections_option("sections", "Comma-separated Section counts for whole-Maestro benchmarks (default: 1,4,16).", "counts", "1,4,16");
+	QCommandLineOption min_time_option("min-time", "Minimum time to spend on each benchmark in milliseconds (default: 200).", "ms", "200");
+	QCommandLineOption filter_option("filter", "Only run benchmarks whose names contain this string.", "name");
+	QCommandLineOption output_option(QStringList() << "o" << "output", "Write results to a file instead of stdout.", "file");
+	parser.addOption(grid_option);
+	parser.addOption(layers_option);
+	parser.addOption(sections_option);
+	parser.addOption(min_time_option);
+	parser.addOption(filter_option);
+	parser.addOption(output_option);
+	parser.process(app);
+
+	QVector<int> grids = parse_list(parser.value(grid_option));
+	QVector<int> layers = parse_list(parser.value(layers_option));
+	QVector<int> sections = parse_list(parser.value(sections_option));
+	if (grids.isEmpty() || layers.isEmpty() || sections.isEmpty()) {
+		QTextStream(stderr) << "Grid sizes, Layer counts, and Section counts must be positive." << endl;
+		return 1;
+	}
+
+	Benchmark benchmark(parser.value(min_time_option).toInt(), parser.value(filter_option));
+	benchmark_maestro_update(benchmark, grids, layers, sections);
+	benchmark_get_pixel_color(benchmark, grids, layers);
+	benchmark_animations(benchmark, grids, layers);
+	benchmark_canvas_draw_frame(benchmark, grids);
+	benchmark_cues(benchmark, grids, layers, sections);
+	benchmark_mix_colors(benchmark);
+
+	QByteArray json = benchmark.get_results().toJson(QJsonDocument::Indented);
+	if (parser.isSet(output_option)) {
+		QFile file(parser.value(output_option));
+		if (!file.open(QFile::WriteOnly | QFile::Truncate)) {
+			QTextStream(stderr) << "Unable to write to " << file.fileName() << endl;
+			return 1;
+		}
+		file.write(json);
+	}
+	else {
+		QTextStream(stdout) << json;
+	}
+
+	return 0;
+}
@@ -0,0 +1,118 @@
+/*
+ * CuefileCacheTest - Checks that the cached Cuefile stays in sync with the Maestro.
+ */
+
+#include <memory>
+#include <QByteArray>
+#include <QDataStream>
+#include <QMutex>
+#include <QMutexLocker>
+#include "catch.hpp"
+#include "canvas/canvas.h"
+#include "controller/cuefilecache.h"
+#include "core/maestro.h"
+#include "core/section.h"
+#include "cue/canvascuehandler.h"
+#include "cue/sectioncuehandler.h"
+#include "utility/cuefileencoder.h"
+#include "utility/cuefileutility.h"
+
+using namespace PixelMaestro;
+using namespace PixelMaestroStudio;
+
+/**
+ * Saves the whole Maestro without going through the cache.
+ * @param maestro Maestro to save.
+ * @param default_interval The Maestro's default refresh interval.
+ * @return Cuefile.
+ */
+static QByteArray save_maestro(Maestro& maestro, uint16_t default_interval) {
+	QByteArray cuefile;
+	QDataStream datastream(&cuefile, QIODevice::WriteOnly);
+	CuefileEncoder::save_maestro(datastream, maestro, default_interval);
+	return cuefile;
+}
+
+TEST_CASE("Cached Cuefile matches a full save while Sections scroll and Canvases change frames.", "[CuefileCache]") {
+	std::unique_ptr<Section[]> sections(new Section[2]);
+	for (uint8_t section = 0; section < 2; section++) {
+		sections[section].set_dimensions(10, 10);
+	}
+	Maestro maestro(nullptr, 0);
+	maestro.set_sections(sections.get(), 2);
+	CueController& controller = CuefileUtility::initialize_cue_controller(maestro);
+	uint16_t interval = maestro.get_timer().get_interval();
+
+	CuefileCache cache;
+	cache.set_maestro(maestro, nullptr);
+	cache.set_default_interval(interval);
+
+	auto run = [&](uint8_t* cue) {
+		controller.run(cue);
+		cache.invalidate(cue);
+	};
+
+	// Section 0 scrolls, and Section 1 has a Layer running an animated Canvas
+	SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+	CanvasCueHandler* canvas_handler = dynamic_cast<CanvasCueHandler*>(controller.get_handler(CueController::Handler::CanvasCueHandler));
+	run(section_handler->set_scroll(0, 0, 500, 0, false, false));
+	run(section_handler->set_layer(1, 0, Colors::MixMode::Alpha, 128));
+	run(section_handler->set_canvas(1, 1, 4));
+	run(canvas_handler->set_frame_timer(1, 1, 100));
+
+	REQUIRE(cache.get_cuefile() == save_maestro(maestro, interval));
+
+	bool scrolled = false;
+	bool changed_frames = false;
+	for (uint32_t time = 100; time <= 1000; time += 100) {
+		maestro.update(time, true);
+		scrolled |= (maestro.get_section(0)->get_offset().x != 0);
+		changed_frames |= (maestro.get_section(1)->get_layer()->section->get_canvas()->get_current_frame_index() != 0);
+
+		REQUIRE(cache.get_cuefile() == save_maestro(maestro, interval));
+	}
+
+	// Make sure the test actually exercised both cases
+	REQUIRE(scrolled);
+	REQUIRE(changed_frames);
+}
+
+TEST_CASE("Cached Cuefile is encoded on a worker thread when the Maestro has a mutex.", "[CuefileCache]") {
+	std::unique_ptr<Section[]> sections(new Section[2]);
+	for (uint8_t section = 0; section < 2; section++) {
+		sections[section].set_dimensions(10, 10);
+	}
+	Maestro maestro(nullptr, 0);
+	maestro.set_sections(sections.get(), 2);
+	CueController& controller = CuefileUtility::initialize_cue_controller(maestro);
+	uint16_t interval = maestro.get_timer().get_interval();
+
+	QMutex mutex;
+	CuefileCache cache;
+	cache.set_maestro(maestro, &mutex);
+	cache.set_default_interval(interval);
+
+	// Same order as MaestroController: the cache is never touched while holding the Maestro's mutex
+	auto run = [&](uint8_t* cue) {
+		{
+			QMutexLocker locker(&mutex);
+			controller.run(cue);
+		}
+		cache.invalidate(cue);
+	};
+
+	SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+	run(section_handler->set_scroll(0, 0, 500, 0, false, false));
+
+	REQUIRE(cache.generate().result() == save_maestro(maestro, interval));
+
+	// Both Sections change, so they're encoded in parallel from the worker
+	run(section_handler->set_layer(1, 0, Colors::MixMode::Alpha, 128));
+	run(section_handler->set_dimensions(0, 0, 20, 20));
+	maestro.update(500, true);
+
+	uint32_t size = cache.update_in_background().result();
+	QByteArray cuefile = save_maestro(maestro, interval);
+	REQUIRE(size == static_cast<uint32_t>(cuefile.size()));
+	REQUIRE(cache.generate().result() == cuefile);
+}
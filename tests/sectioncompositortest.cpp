@@ -0,0 +1,162 @@
+/*
+ * SectionCompositorTest - Checks that composited Sections match Section::get_pixel_color().
+ */
+
+#include <memory>
+#include <vector>
+#include <QColor>
+#include "animation/animationtype.h"
+#include "catch.hpp"
+#include "colorpresets.h"
+#include "controller/sectioncompositor.h"
+#include "core/maestro.h"
+#include "core/palette.h"
+#include "core/section.h"
+#include "cue/animationcuehandler.h"
+#include "cue/sectioncuehandler.h"
+#include "utility/cuefileutility.h"
+
+using namespace PixelMaestro;
+using namespace PixelMaestroStudio;
+
+/// Names of each MixMode, in enum order.
+static const char* MIX_MODE_NAMES[] = { "None", "Alpha", "Multiply", "Overlay" };
+
+/**
+ * Checks every Pixel composited by a SectionCompositor against get_pixel_color().
+ * @param section Section to check.
+ */
+static void check_composite(Section& section) {
+	const Point& dimensions = section.get_dimensions();
+	std::vector<QRgb> output(dimensions.size());
+
+	SectionCompositor compositor;
+	compositor.composite(section, output.data());
+
+	for (uint16_t y = 0; y < dimensions.y; y++) {
+		for (uint16_t x = 0; x < dimensions.x; x++) {
+			Colors::RGB color = section.get_pixel_color(x, y);
+			INFO("x: " << x << ", y: " << y);
+			REQUIRE(output[(y * dimensions.x) + x] == qRgb(color.r, color.g, color.b));
+		}
+	}
+}
+
+TEST_CASE("Composited Sections match get_pixel_color() for every mix mode and Layer depth.", "[SectionCompositor]") {
+	Palette palette(ColorPresets::Colorwheel, 12);
+
+	for (uint8_t mode = 0; mode < sizeof(MIX_MODE_NAMES) / sizeof(MIX_MODE_NAMES[0]); mode++) {
+		for (uint8_t num_layers = 1; num_layers <= 3; num_layers++) {
+			for (uint8_t fallback = 0; fallback <= num_layers; fallback++) {
+				std::unique_ptr<Section[]> sections(new Section[1]);
+				sections[0].set_dimensions(12, 7);
+				Maestro maestro(nullptr, 0);
+				maestro.set_sections(sections.get(), 1);
+				CueController& controller = CuefileUtility::initialize_cue_controller(maestro);
+				SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+				AnimationCueHandler* animation_handler = dynamic_cast<AnimationCueHandler*>(controller.get_handler(CueController::Handler::AnimationCueHandler));
+
+				// Alternate Animations so that each Layer has plenty of black Pixels and colored Pixels to mix
+				for (uint8_t layer = 0; layer < num_layers; layer++) {
+					if (layer + 1 < num_layers) {
+						controller.run(section_handler->set_layer(0, layer, static_cast<Colors::MixMode>(mode), 64 + (layer * 64)));
+					}
+					controller.run(section_handler->set_animation(0, layer, (layer % 2 == 0) ? AnimationType::Wave : AnimationType::Sparkle, false));
+					controller.run(animation_handler->set_palette(0, layer, palette));
+				}
+
+				// Dim one of the Layers so that it and everything above it goes through get_pixel_color()
+				if (fallback < num_layers) {
+					controller.run(section_handler->set_brightness(0, fallback, 100));
+				}
+
+				for (uint32_t time = 100; time <= 300; time += 100) {
+					maestro.update(time, true);
+
+					INFO("Mix mode: " << MIX_MODE_NAMES[mode] << ", Layers: " << static_cast<int>(num_layers) << ", dimmed Layer: " << static_cast<int>(fallback));
+					check_composite(sections[0]);
+				}
+			}
+		}
+	}
+}
+
+TEST_CASE("Composited Sections match get_pixel_color() when Layers are offset, mirrored, wrapped, and scrolled.", "[SectionCompositor]") {
+	Palette palette(ColorPresets::Colorwheel, 12);
+
+	/*
+	 * Each case sets one of these on every Layer, rotating the settings so that neighbouring Layers differ.
+	 * 0: nothing, 1: offset, 2: offset without wrapping, 3: mirror x, 4: mirror y, 5: mirror both and offset, 6: scroll, 7: scroll without wrapping.
+	 */
+	const uint8_t num_settings = 8;
+	for (uint8_t setting = 0; setting < num_settings; setting++) {
+		std::unique_ptr<Section[]> sections(new Section[1]);
+		sections[0].set_dimensions(11, 8);
+		Maestro maestro(nullptr, 0);
+		maestro.set_sections(sections.get(), 1);
+		CueController& controller = CuefileUtility::initialize_cue_controller(maestro);
+		SectionCueHandler* section_handler = dynamic_cast<SectionCueHandler*>(controller.get_handler(CueController::Handler::SectionCueHandler));
+		AnimationCueHandler* animation_handler = dynamic_cast<AnimationCueHandler*>(controller.get_handler(CueController::Handler::AnimationCueHandler));
+
+		const uint8_t num_layers = 3;
+		for (uint8_t layer = 0; layer < num_layers; layer++) {
+			if (layer + 1 < num_layers) {
+				controller.run(section_handler->set_layer(0, layer, (layer == 0) ? Colors::MixMode::Alpha : Colors::MixMode::Overlay, 128));
+			}
+			controller.run(section_handler->set_animation(0, layer, (layer % 2 == 0) ? AnimationType::Radial : AnimationType::Sparkle, false));
+			controller.run(animation_handler->set_palette(0, layer, palette));
+
+			switch ((setting + layer) % num_settings) {
+				case 1:
+					controller.run(section_handler->set_offset(0, layer, 3, 5));
+					break;
+				case 2:
+					controller.run(section_handler->set_wrap(0, layer, false));
+					controller.run(section_handler->set_offset(0, layer, 4, 2));
+					break;
+				case 3:
+					controller.run(section_handler->set_mirror(0, layer, true, false));
+					break;
+				case 4:
+					controller.run(section_handler->set_mirror(0, layer, false, true));
+					break;
+				case 5:
+					controller.run(section_handler->set_mirror(0, layer, true, true));
+					controller.run(section_handler->set_offset(0, layer, 7, 1));
+					break;
+				case 6:
+					controller.run(section_handler->set_scroll(0, layer, 300, 700, false, true));
+					break;
+				case 7:
+					controller.run(section_handler->set_wrap(0, layer, false));
+					controller.run(section_handler->set_scroll(0, layer, 500, 400, true, false));
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Reuse one compositor across frames so that its remap tables have to follow the scrolling offsets
+		std::vector<QRgb> output(sections[0].get_dimensions().size());
+		SectionCompositor compositor;
+		for (uint32_t time = 100; time <= 2000; time += 100) {
+			maestro.update(time, true);
+
+			// Dimming the middle Layer halfway through sends it and the Layer above it through get_pixel_color()
+			if (time == 1000) {
+				controller.run(section_handler->set_brightness(0, 1, 180));
+			}
+
+			compositor.composite(sections[0], output.data());
+
+			const Point& dimensions = sections[0].get_dimensions();
+			for (uint16_t y = 0; y < dimensions.y; y++) {
+				for (uint16_t x = 0; x < dimensions.x; x++) {
+					Colors::RGB color = sections[0].get_pixel_color(x, y);
+					INFO("Setting: " << static_cast<int>(setting) << ", time: " << time << ", x: " << x << ", y: " << y);
+					REQUIRE(output[(y * dimensions.x) + x] == qRgb(color.r, color.g, color.b));
+				}
+			}
+		}
+	}
+}
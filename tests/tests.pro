@@ -6,7 +6,8 @@
 
 # QT       += testlib
 
-QT       -= gui
+QT       += gui
+QT       += concurrent
 
 TARGET	  = tests/tests/colorstest
 CONFIG   += console
@@ -68,7 +69,13 @@ SOURCES += \
     ../lib/PixelMaestro/tests/tests/utilitytest.cpp \
     ../lib/PixelMaestro/tests/tests/timertest.cpp \
     ../lib/PixelMaestro/tests/tests/animationtimertest.cpp \
-    ../lib/PixelMaestro/tests/tests/pointtest.cpp
+    ../lib/PixelMaestro/tests/tests/pointtest.cpp \
+    ../src/controller/cuefilecache.cpp \
+    ../src/controller/sectioncompositor.cpp \
+    ../src/utility/cuefileencoder.cpp \
+    ../src/utility/performancemonitor.cpp \
+    cuefilecachetest.cpp \
+    sectioncompositortest.cpp
 
 HEADERS += \
         .../lib/PixelMaestro/src/canvas/fonts/font.h \
@@ -113,11 +120,17 @@ HEADERS += \
     ../lib/PixelMaestro/tests/tests/showtest.h \
     ../lib/PixelMaestro/tests/tests/utilitytest.h \
     ../lib/PixelMaestro/tests/catch/include/catch.hpp \
-    ../lib/PixelMaestro/tests/tests/pointtest.h
+    ../lib/PixelMaestro/tests/tests/pointtest.h \
+    ../src/controller/cuefilecache.h \
+    ../src/controller/sectioncompositor.h \
+    ../src/utility/cuefileencoder.h \
+    ../src/utility/cuefileutility.h \
+    ../src/utility/performancemonitor.h
 
 INCLUDEPATH += \
         $$PWD/../lib/PixelMaestro/src \
         $$PWD/../lib/PixelMaestro/tests/tests \
-        $$PWD/../lib/PixelMaestro/tests/catch/include
+        $$PWD/../lib/PixelMaestro/tests/catch/include \
+        $$PWD/../src
 
 DEFINES += SRCDIR=\\\"$$PWD/\\\"